@@ -0,0 +1,10 @@
+#pragma once
+
+#include <cstdint>
+
+// Heap allocations made by the calling thread so far. Global operator new is
+// only replaced in builds configured with -DCOUNT_ALLOCATIONS=ON (which defines
+// PGV_COUNT_ALLOCATIONS); otherwise nothing is counted and both stay 0.
+bool allocationCountingEnabled();
+uint64_t getThreadAllocationCount();
+uint64_t getThreadAllocatedBytes();
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "frustum.h"
+
+// Bounding boxes (center and half size) and their bounding spheres, one array
+// per component. The arrays are padded to a multiple of LANES so the widest
+// culling path never needs a scalar tail.
+struct BoundsArrays {
+    static constexpr size_t LANES = 8;
+
+    std::vector<float> centerX, centerY, centerZ;
+    std::vector<float> extentX, extentY, extentZ;
+    std::vector<float> radius;
+
+    size_t size() const { return count; }
+    size_t paddedSize() const { return centerX.size(); }
+    // Keeps the first count entries, new ones are empty boxes at the origin
+    void resize(size_t count);
+    void set(size_t i, const glm::vec3& center, const glm::vec3& extent);
+
+private:
+    size_t count = 0;
+};
+
+enum CullResult : uint8_t {
+    CULL_OUTSIDE = 0,
+    CULL_INTERSECTING = 1,
+    CULL_INSIDE = 2  // The whole sphere is in view, nothing inside it needs a frustum test
+};
+
+enum class CullPath {
+    Scalar,
+    SSE2,
+    AVX
+};
+
+// Widest path the compiler and the running CPU both support
+CullPath bestCullPath();
+const char* cullPathName(CullPath path);
+
+// Tests every box against the frustum's planes, which must be in the space of
+// the boxes. results needs paddedSize() entries.
+void cullBounds(const Frustum& frustum, const BoundsArrays& bounds, uint8_t* results,
+                CullPath path = bestCullPath());
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Polls a set of files on a background thread and reports the ones whose
+// contents changed. The baseline is each file's size and timestamp. A file is
+// only hashed once those changed and then held for one interval, so
+// half-written exports are never reported. After its first change, touching
+// a file without changing its contents reports nothing.
+class FileWatcher {
+public:
+    explicit FileWatcher(std::chrono::milliseconds interval = std::chrono::milliseconds(500));
+    ~FileWatcher();
+
+    FileWatcher(const FileWatcher&) = delete;
+    FileWatcher& operator=(const FileWatcher&) = delete;
+
+    // Replaces the watched set. Files already watched keep their baseline,
+    // new ones start from their current size and timestamp
+    void watch(const std::vector<std::string>& files);
+    // Files whose contents changed since the last call, as passed to watch()
+    std::vector<std::string> takeChanged();
+
+private:
+    struct FileState {
+        uintmax_t size = 0;
+        int64_t mtime = 0;
+        uint64_t hash = 0;
+        bool hashed = false;  // The baseline stat has no hash
+        bool operator==(const FileState& other) const { return size == other.size && mtime == other.mtime; }
+        bool operator!=(const FileState& other) const { return !(*this == other); }
+    };
+
+    std::chrono::milliseconds interval;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::string> files;
+    size_t generation = 0;  // Bumped by watch() so the worker rebuilds its baseline
+    std::vector<std::string> changed;
+    bool stopping = false;
+    std::thread worker;
+
+    void run();
+    static bool stat(const std::string& file, FileState& state);
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <glm/glm.hpp>
+
+// View frustum as six inward-facing planes (xyz = unit normal, w = offset).
+// Extracted from a clip matrix, so passing projection * view * model gives
+// planes in that model's local space.
+struct Frustum {
+    glm::vec4 planes[6];
+
+    static Frustum fromMatrix(const glm::mat4& clip) {
+        glm::vec4 row[4];
+        for (int i = 0; i < 4; i++) {
+            row[i] = glm::vec4(clip[0][i], clip[1][i], clip[2][i], clip[3][i]);
+        }
+        Frustum frustum;
+        frustum.planes[0] = row[3] + row[0];  // left
+        frustum.planes[1] = row[3] - row[0];  // right
+        frustum.planes[2] = row[3] + row[1];  // bottom
+        frustum.planes[3] = row[3] - row[1];  // top
+        frustum.planes[4] = row[3] + row[2];  // near
+        frustum.planes[5] = row[3] - row[2];  // far
+        for (glm::vec4& plane : frustum.planes) {
+            float length = glm::length(glm::vec3(plane));
+            if (length > 0.0f) {
+                plane /= length;
+            }
+        }
+        return frustum;
+    }
+
+    bool intersectsSphere(const glm::vec3& center, float radius) const {
+        for (const glm::vec4& plane : planes) {
+            if (glm::dot(glm::vec3(plane), center) + plane.w < -radius) {
+                return false;
+            }
+        }
+        return true;
+    }
+};
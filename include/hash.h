@@ -0,0 +1,71 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+// 64-bit FNV-1a, chain calls by passing the previous result as seed
+inline uint64_t fnv1a(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+// FNV-1a style hash taking 8 bytes per step, for large binary arrays where the
+// byte-wise loop is too slow. Not interchangeable with fnv1a.
+inline uint64_t hashWords(const void* data, size_t size, uint64_t hash = 14695981039346656037ull) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    size_t i = 0;
+    for (; i + 8 <= size; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, bytes + i, sizeof(word));
+        hash ^= word;
+        hash *= 1099511628211ull;
+        hash ^= hash >> 32;
+    }
+    return fnv1a(bytes + i, size - i, hash);
+}
+
+// Hash of a file's contents, false if it cannot be read to the end
+inline bool hashFile(const std::string& filename, uint64_t& hash) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file) {
+        return false;
+    }
+    std::vector<char> buffer(1 << 20);
+    hash = fnv1a(nullptr, 0);
+    while (file) {
+        file.read(buffer.data(), static_cast<std::streamsize>(buffer.size()));
+        hash = fnv1a(buffer.data(), static_cast<size_t>(file.gcount()), hash);
+    }
+    return !file.bad();
+}
+
+// Whether two files have the same bytes, false if either cannot be read
+inline bool sameFileContents(const std::string& a, const std::string& b) {
+    std::ifstream fileA(a, std::ios::binary);
+    std::ifstream fileB(b, std::ios::binary);
+    if (!fileA || !fileB) {
+        return false;
+    }
+    std::vector<char> bufferA(1 << 20);
+    std::vector<char> bufferB(bufferA.size());
+    for (;;) {
+        fileA.read(bufferA.data(), static_cast<std::streamsize>(bufferA.size()));
+        fileB.read(bufferB.data(), static_cast<std::streamsize>(bufferB.size()));
+        const std::streamsize countA = fileA.gcount();
+        if (fileA.bad() || fileB.bad() || countA != fileB.gcount() ||
+            std::memcmp(bufferA.data(), bufferB.data(), static_cast<size_t>(countA)) != 0) {
+            return false;
+        }
+        if (countA == 0) {
+            return true;
+        }
+    }
+}
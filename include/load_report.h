@@ -0,0 +1,79 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+
+// Time and work of one load stage. Stages recorded on worker threads are
+// summed over every call, so they can exceed the wall-clock load time.
+struct LoadStage {
+    std::string name;
+    double milliseconds = 0.0;
+    uint64_t bytes = 0;
+    uint64_t items = 0;
+    std::string itemName;  // What items counts: "triangles", "textures", ...
+    size_t calls = 0;
+    uint64_t allocations = 0;  // Heap allocations on the recording threads, see allocation_counter.h
+
+    double megabytesPerSecond() const { return milliseconds > 0.0 ? bytes / (1024.0 * 1024.0) / (milliseconds / 1000.0) : 0.0; }
+    double itemsPerSecond() const { return milliseconds > 0.0 ? items / (milliseconds / 1000.0) : 0.0; }
+};
+
+// Per-stage timings of one model load, in the order stages first ran.
+// Safe to record into from several threads.
+class LoadReport {
+public:
+    LoadReport();
+
+    // Adds to the stage called name, creating it on first use
+    void record(const std::string& name, double milliseconds, uint64_t bytes, uint64_t items,
+                const char* itemName = "", uint64_t allocations = 0);
+
+    std::vector<LoadStage> getStages() const;
+    // Wall-clock time since construction, frozen by finish()
+    double getElapsedMilliseconds() const;
+
+    void finish();
+    bool isFinished() const;
+
+    void print(std::ostream& out) const;
+    // One JSON object with the model path, totals, process memory and every stage
+    std::string toJson(const std::string& modelPath, bool fromCache) const;
+    // Writes toJson to directory/<model>-<timestamp>.json, returns the path or "" on failure
+    std::string write(const std::string& directory, const std::string& modelPath, bool fromCache) const;
+
+private:
+    mutable std::mutex mutex;
+    std::vector<LoadStage> stages;
+    std::chrono::steady_clock::time_point start;
+    double elapsed = 0.0;
+    bool finished = false;
+};
+
+// Records the time between construction and destruction as one call of a
+// stage, along with the heap allocations the constructing thread made
+// meanwhile. A null report makes it a no-op.
+class ScopedTimer {
+public:
+    ScopedTimer(LoadReport* report, const char* stage, const char* itemName = "");
+    ~ScopedTimer();
+
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+
+    void addBytes(uint64_t count) { bytes += count; }
+    void addItems(uint64_t count) { items += count; }
+
+private:
+    LoadReport* report;
+    const char* stage;
+    const char* itemName;
+    std::chrono::steady_clock::time_point start;
+    uint64_t startAllocations;
+    uint64_t bytes = 0;
+    uint64_t items = 0;
+};
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <ostream>
+#include <string>
+
+enum class LogLevel : int {
+    Debug,    // Per-mesh and per-texture detail
+    Info,     // One line per load step
+    Warning,
+    Error,
+    Off
+};
+
+// Messages below the level are dropped before any formatting happens. Default Info.
+void setLogLevel(LogLevel level);
+LogLevel getLogLevel();
+const char* logLevelName(LogLevel level);
+// "debug", "info", "warning", "error" or "off"
+bool parseLogLevel(const std::string& name, LogLevel& level);
+
+// Blocks until every message logged so far has been written out
+void flushLog();
+
+struct LogStats {
+    uint64_t written = 0;
+    uint64_t dropped = 0;  // Debug/Info lines lost to a full queue
+    double sinkMilliseconds = 0.0;  // Spent writing on the background thread
+};
+LogStats getLogStats();
+
+// Used by the macros below
+extern std::atomic<int> logMinimumLevel;
+inline bool logEnabled(LogLevel level) {
+    return static_cast<int>(level) >= logMinimumLevel.load(std::memory_order_relaxed);
+}
+std::ostream& logBegin();
+void logCommit(LogLevel level);
+
+// LOG_INFO("Loaded " << count << " meshes"). Formatting happens on the calling
+// thread into a reused per-thread buffer, the line is then queued without locks
+// and written by a background thread. A disabled level costs one relaxed load.
+#define PGV_LOG(level, message)                 \
+    do {                                        \
+        if (logEnabled(level)) {                \
+            logBegin() << message;              \
+            logCommit(level);                   \
+        }                                       \
+    } while (0)
+
+#define LOG_DEBUG(message) PGV_LOG(LogLevel::Debug, message)
+#define LOG_INFO(message) PGV_LOG(LogLevel::Info, message)
+#define LOG_WARNING(message) PGV_LOG(LogLevel::Warning, message)
+#define LOG_ERROR(message) PGV_LOG(LogLevel::Error, message)
@@ -0,0 +1,8 @@
+#pragma once
+
+#include <cstddef>
+
+// Resident set size of this process (the working set on Windows) in bytes,
+// and the highest it has been so far. Both are 0 where unsupported.
+size_t getResidentBytes();
+size_t getPeakResidentBytes();
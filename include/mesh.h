@@ -2,8 +2,10 @@
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
+#include <limits>
 #include <string>
 #include <vector>
+#include "scene_graph.h"
 #include "shader.h"
 
 struct Vertex {
@@ -21,16 +23,158 @@ struct Texture {
     float shininess = 32.0f; // Default shininess
 };
 
+// GPU vertex layout: 32-byte Vertex as is, or the 16-byte PackedVertex
+// (vertex_quantize.h) that phong.vert dequantizes
+enum class VertexFormat {
+    Full,
+    Quantized
+};
+
+// One level of detail: a range of the mesh's index list over the shared vertices
+struct MeshLod {
+    unsigned int indexOffset = 0;
+    unsigned int indexCount = 0;
+    float error = 0.0f;  // Geometric error as a fraction of the mesh radius
+};
+
+// A run of at most 124 triangles with bounds for CPU culling, see meshlet.h
+struct Meshlet {
+    unsigned int indexOffset = 0;
+    unsigned int indexCount = 0;
+    glm::vec3 center = glm::vec3(0.0f);
+    float radius = 0.0f;
+    glm::vec3 coneAxis = glm::vec3(0.0f, 0.0f, 1.0f);
+    float coneCutoff = 1.0f;  // Sine of the normal cone's half angle, 1 never culls
+};
+
+// Per-frame camera inputs for level-of-detail selection and meshlet culling
+struct DrawView {
+    glm::mat4 model = glm::mat4(1.0f);
+    glm::mat4 viewProjection = glm::mat4(1.0f);
+    glm::vec3 cameraPosition = glm::vec3(0.0f);
+    float pixelsPerUnit = 1.0f;  // Viewport height / (2 tan(fovy / 2))
+    float maxPixelError = 1.0f;  // Draw the coarsest level whose error projects below this
+    bool cullMeshlets = true;
+    bool cullMeshes = true;  // Skip meshes whose bounds are outside the frustum
+};
+
+struct MeshletCullContext;
+
+// CPU-side mesh data before it is uploaded to the GPU
+struct MeshData {
+    std::vector<Vertex> vertices;
+    std::vector<unsigned int> indices;  // All levels of detail back to back
+    std::vector<Texture> textures;
+    std::vector<MeshLod> lods;  // Empty means indices is a single level
+    std::vector<Meshlet> meshlets;  // Cover every level in index order, may be empty
+    // Model-space transforms of the nodes referencing the mesh when the hierarchy
+    // is kept, and those nodes in the model's scene graph; empty draws it once as is
+    std::vector<glm::mat4> instances;
+    std::vector<uint32_t> instanceNodes;
+    // Model space, covering every instance
+    glm::vec3 minBounds = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 maxBounds = glm::vec3(std::numeric_limits<float>::lowest());
+    // The vertices themselves, before any instance transform
+    glm::vec3 localMinBounds = glm::vec3(std::numeric_limits<float>::max());
+    glm::vec3 localMaxBounds = glm::vec3(std::numeric_limits<float>::lowest());
+};
+
 class Mesh {
 public:
     std::vector<Vertex> vertices;
     std::vector<unsigned int> indices;
     std::vector<Texture> textures;
     
-    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures);
-    void Draw(Shader &shader);
+    // localMin and localMax bound the vertices (MeshData::localMinBounds), the
+    // mesh takes them as given instead of walking the positions again
+    Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures,
+         const glm::vec3& localMin, const glm::vec3& localMax, VertexFormat format = VertexFormat::Full, std::vector<MeshLod> lods = std::vector<MeshLod>(),
+         std::vector<Meshlet> meshlets = std::vector<Meshlet>(),
+         std::vector<glm::mat4> instances = std::vector<glm::mat4>());
+    // Owns its GL buffers, so it can be moved but not copied
+    ~Mesh();
+    Mesh(const Mesh&) = delete;
+    Mesh& operator=(const Mesh&) = delete;
+    Mesh(Mesh&& other) noexcept;
+    Mesh& operator=(Mesh&& other) noexcept;
+
+    // Swaps in new geometry and materials, reusing this mesh's VAO and buffers
+    void replace(std::vector<Vertex> newVertices, std::vector<unsigned int> newIndices,
+                 std::vector<Texture> newTextures, const glm::vec3& localMin, const glm::vec3& localMax,
+                 std::vector<MeshLod> newLods, std::vector<Meshlet> newMeshlets, std::vector<glm::mat4> newInstances);
+
+    // Draws one level, only its visible meshlets when cull is given.
+    // Meshes with several instances draw the level once per instance and skip
+    // meshlet culling, whose bounds are in mesh space; a single instance is
+    // culled with cull given in its own space. Returns the number of triangles submitted.
+    size_t Draw(Shader &shader, size_t lod = 0, const MeshletCullContext* cull = nullptr);
+
+    // Level 0 is full detail
+    size_t getLodCount() const { return lods.size(); }
+    const MeshLod& getLod(size_t lod) const { return lods[lod]; }
+    // Instanced meshes pick the level their nearest instance needs
+    size_t selectLod(const DrawView& view) const;
+
+    bool isInstanced() const { return !instances.empty(); }
+    size_t getInstanceCount() const { return instances.empty() ? 1 : instances.size(); }
+    size_t getInstanceBytes() const { return instances.size() * sizeof(glm::mat4); }
+    const glm::mat4& getInstanceTransform(size_t instance) const { return instances[instance]; }
+    // Model space to the space of the only instance, for culling single-instance meshes
+    const glm::mat4& getInverseInstanceTransform() const { return inverseInstance; }
+
+    // The scene graph nodes the instances follow, the transforms are current as of graphVersion
+    void setInstanceNodes(std::vector<uint32_t> nodes, uint64_t graphVersion);
+    const std::vector<uint32_t>& getInstanceNodes() const { return instanceNodes; }
+    // Pulls moved instances from the graph after SceneGraph::update() and
+    // re-uploads the transform buffer if any moved, returns whether one did; all
+    // re-reads every node, for a graph whose versions this mesh did not follow
+    bool refreshInstances(const SceneGraph& graph, bool all = false);
+    // Box of the mesh's own vertices, before any instance transform
+    const glm::vec3& getBoundsCenter() const { return boundsCenter; }
+    const glm::vec3& getBoundsExtent() const { return boundsExtent; }
+
+    VertexFormat getVertexFormat() const { return vertexFormat; }
+    // GPU vertex memory, and what it would be with the full 32-byte layout
+    size_t getVertexBytes() const;
+    size_t getFullVertexBytes() const { return vertexCount * sizeof(Vertex); }
+
+    // GL_UNSIGNED_SHORT when every index fits in 16 bits, GL_UNSIGNED_INT otherwise
+    GLenum getIndexType() const { return indexType; }
+    size_t getIndexBytes() const { return indexCount * (indexType == GL_UNSIGNED_SHORT ? 2 : 4); }
+    size_t getIndexBytesSaved() const { return indexCount * sizeof(unsigned int) - getIndexBytes(); }
+
+    // Frees the CPU copies of vertices and indices once the GPU has them;
+    // bounds, levels and meshlets stay for drawing and culling
+    void releaseCpuData();
 
 private:
-    unsigned int VAO, VBO, EBO;
+    unsigned int VAO = 0, VBO = 0, EBO = 0;
+    unsigned int instanceVBO = 0;  // Per-instance model matrices, attributes 3-6
+    std::vector<glm::mat4> instances;
+    std::vector<uint32_t> instanceNodes;
+    uint64_t instanceVersion = 0;
+    glm::mat4 inverseInstance = glm::mat4(1.0f);
+    GLenum indexType = GL_UNSIGNED_INT;
+    // What the GPU buffers hold, still known after releaseCpuData
+    size_t vertexCount = 0;
+    size_t indexCount = 0;
+    VertexFormat vertexFormat = VertexFormat::Full;
+    std::vector<MeshLod> lods;
+    std::vector<Meshlet> meshlets;
+    // Scratch for glMultiDrawElements
+    std::vector<GLsizei> drawCounts;
+    std::vector<const void*> drawOffsets;
+    // Bounding box as center and half size, and its sphere for LOD selection
+    glm::vec3 boundsCenter = glm::vec3(0.0f);
+    glm::vec3 boundsExtent = glm::vec3(0.0f);
+    float boundsRadius = 0.0f;
+    glm::vec3 boundsMin = glm::vec3(0.0f);  // Exact corners, the quantization range
+    glm::vec3 boundsMax = glm::vec3(0.0f);
+    // Dequantization: position = positionOffset + unorm16 * positionScale
+    glm::vec3 positionOffset = glm::vec3(0.0f);
+    glm::vec3 positionScale = glm::vec3(1.0f);
+    void setupBounds(const glm::vec3& localMin, const glm::vec3& localMax);
     void setupMesh();
+    void setupQuantizedAttributes();
+    void setupInstances();
 }; 
\ No newline at end of file
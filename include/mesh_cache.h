@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <glm/glm.hpp>
+#include "mapped_file.h"
+#include "mesh.h"
+#include "scene_graph.h"
+
+// Processing the viewer applies on top of Assimp's post-process steps
+const unsigned int MESH_PROCESS_OPTIMIZE = 1u << 0;
+const unsigned int MESH_PROCESS_MESHLETS = 1u << 1;
+
+// Identifies one import of a source file: a cache entry is only valid
+// for the exact file contents and processing flags it was built from
+struct MeshCacheKey {
+    std::string sourcePath;
+    uint64_t sourceSize = 0;
+    int64_t sourceMtime = 0;
+    unsigned int importFlags = 0;
+    unsigned int importProfile = 0;  // Named preset the flags came from
+    unsigned int processFlags = 0;
+    unsigned int lodLevels = 0;
+    float lodMaxError = 0.0f;
+};
+
+// An open cache entry. Geometry stays in the file mapping until a mesh is
+// read, so entries larger than RAM can be paged in one mesh at a time.
+// Reads only touch the mapping and are safe from any thread.
+class MeshCacheEntry {
+public:
+    bool isOpen() const { return file.isOpen(); }
+    size_t getMeshCount() const { return meshCount; }
+    glm::vec3 getMinBounds() const { return minBounds; }
+    glm::vec3 getMaxBounds() const { return maxBounds; }
+
+    // Only touch the table of contents
+    void getMeshBounds(size_t mesh, glm::vec3& meshMin, glm::vec3& meshMax) const;
+    size_t getGeometryBytes(size_t mesh) const;
+
+    // Copy one mesh's vertices, indices, LODs, meshlets and instances, or its materials, out of the mapping
+    bool readGeometry(size_t mesh, MeshData& out) const;
+    bool readMaterials(size_t mesh, std::vector<Texture>& out) const;
+    // Drops the mesh's geometry pages from memory once they were copied
+    void releaseGeometry(size_t mesh) const;
+    // Rebuilds the model's node hierarchy, empty unless it was imported with instancing
+    void readNodes(SceneGraph& nodes) const;
+
+private:
+    friend class MeshCache;
+    MappedFile file;
+    uint64_t tocOffset = 0;
+    size_t meshCount = 0;
+    uint64_t nodeOffset = 0;
+    size_t nodeCount = 0;
+    glm::vec3 minBounds = glm::vec3(0.0f);
+    glm::vec3 maxBounds = glm::vec3(0.0f);
+};
+
+// Versioned on-disk cache of the final vertex/index/LOD/meshlet/instance/material arrays and
+// the scene graph of a model. Entries are memory-mapped on load so a hit never touches Assimp.
+class MeshCache {
+public:
+    static constexpr uint32_t VERSION = 8;
+
+    explicit MeshCache(std::string directory = "cache");
+
+    // Stats the source file, returns false if it does not exist
+    static bool makeKey(const std::string& sourcePath, unsigned int importFlags, unsigned int processFlags,
+                        MeshCacheKey& key);
+
+    // Maps and validates an entry without reading any geometry
+    bool open(const MeshCacheKey& key, MeshCacheEntry& entry) const;
+    bool load(const MeshCacheKey& key, std::vector<MeshData>& meshes,
+              glm::vec3& minBounds, glm::vec3& maxBounds, SceneGraph& nodes) const;
+    bool store(const MeshCacheKey& key, const std::vector<MeshData>& meshes,
+               const glm::vec3& minBounds, const glm::vec3& maxBounds, const SceneGraph& nodes) const;
+
+    // Named after the source and processing, then the source's size and timestamp
+    std::string entryPath(const MeshCacheKey& key) const;
+
+private:
+    std::string directory;
+
+    // Name part shared by every entry of one source and processing
+    std::string entryPrefix(const MeshCacheKey& key) const;
+    // Deletes the entries of older versions of the source, best effort
+    void removeStale(const MeshCacheKey& key) const;
+};
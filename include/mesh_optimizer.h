@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "mesh.h"
+
+// Post-transform cache efficiency of an index buffer under a FIFO cache
+struct VertexCacheStats {
+    size_t triangles = 0;
+    size_t vertices = 0;        // Distinct vertices referenced
+    size_t transformed = 0;     // Cache misses
+    float acmr() const { return triangles ? static_cast<float>(transformed) / triangles : 0.0f; }
+    float atvr() const { return vertices ? static_cast<float>(transformed) / vertices : 0.0f; }
+};
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount,
+                                    unsigned int cacheSize = 16);
+
+// Reorders triangles for post-transform cache reuse (Forsyth's linear-speed algorithm)
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount);
+// Same, in place over indexCount indices of a larger list (e.g. one level of detail)
+void optimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount);
+
+// Reorders the cache-coherent clusters produced by optimizeVertexCache so that
+// outward-facing clusters far from the mesh centre are drawn first. Clusters
+// split where the cache restarts, so the reordering keeps the cache gains.
+void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices);
+
+// Renumbers vertices in order of first use and drops unreferenced ones
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices);
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include "mesh.h"
+
+// Quadric error metric simplification (Garland & Heckbert) by collapsing edges
+// onto existing vertices, so every level indexes the same vertex buffer.
+// Stops at targetIndexCount or before a collapse would move the surface by more
+// than targetError, given as a fraction of the mesh radius. Vertices on open
+// borders and attribute seams never move. The error reached is written to
+// resultError in the same units.
+std::vector<unsigned int> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                       size_t targetIndexCount, float targetError, float* resultError = nullptr);
+
+// Appends up to `levels` simplified levels, each aiming for half the triangles
+// of the one before, to indices and describes all levels (including the
+// original as level 0) in lods. Stops early once simplification stalls or
+// the accumulated error would exceed maxError.
+void buildLodChain(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+                   std::vector<MeshLod>& lods, unsigned int levels, float maxError);
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
+#include <glm/glm.hpp>
+#include "frustum.h"
+#include "mesh.h"
+#include "mesh_cache.h"
+#include "thread_pool.h"
+
+// Residency limits for out-of-core rendering
+struct StreamingBudget {
+    size_t cpuBytes = size_t(1024) << 20;  // Paged-in copies waiting for upload
+    size_t gpuBytes = size_t(512) << 20;
+    size_t uploadBytesPerFrame = size_t(16) << 20;
+};
+
+// Out-of-core geometry backed by an open mesh cache entry. Each mesh of the
+// entry is a chunk: visible chunks are paged in from the mapping on a
+// background thread, uploaded on the GL thread, which drops the CPU copy, and
+// the least recently visible ones are evicted to stay within the GPU budget.
+// Everything except the page-in itself runs on the GL thread.
+class MeshStreamer {
+public:
+    MeshStreamer(MeshCacheEntry entry, VertexFormat format, const StreamingBudget& budget);
+    ~MeshStreamer();
+
+    MeshStreamer(const MeshStreamer&) = delete;
+    MeshStreamer& operator=(const MeshStreamer&) = delete;
+
+    size_t getChunkCount() const { return chunks.size(); }
+    // Materials are loaded for every chunk up front, their texture ids are filled in by the caller
+    std::vector<Texture>& getMaterials(size_t chunk) { return chunks[chunk].textures; }
+
+    // Uploads chunks that finished paging in (about uploadBudget bytes), marks the
+    // chunks intersecting the model-space frustum visible, evicts least recently
+    // visible chunks over budget and requests the nearest missing visible ones.
+    void update(const Frustum& frustum, const glm::vec3& cameraPosition, size_t uploadBudget);
+    // Resident and visible in the last update, nullptr otherwise
+    Mesh* getVisibleMesh(size_t chunk);
+
+    void setBudget(const StreamingBudget& newBudget) { budget = newBudget; }
+    size_t getResidentCount() const { return residentCount; }
+    size_t getPendingCount() const { return inFlight; }
+    size_t getCpuBytes() const { return cpuBytes; }
+    size_t getGpuBytes() const { return gpuBytes; }
+    size_t getTriangleCount() const { return triangleCount; }
+
+private:
+    struct Chunk {
+        glm::vec3 center = glm::vec3(0.0f);
+        float radius = 0.0f;
+        size_t bytes = 0;        // Geometry as stored, also the CPU and GPU estimate before upload
+        size_t triangles = 0;
+        std::vector<Texture> textures;
+        std::unique_ptr<Mesh> mesh;
+        uint64_t lastVisibleFrame = 0;
+        bool visible = false;
+        bool requested = false;
+        bool failed = false;
+    };
+
+    struct PagedChunk {
+        size_t chunk = 0;
+        bool ok = false;
+        MeshData data;
+    };
+
+    // Bounds page-in latency when the camera turns quickly
+    static constexpr size_t MAX_IN_FLIGHT = 8;
+
+    MeshCacheEntry entry;
+    VertexFormat format;
+    StreamingBudget budget;
+    std::vector<Chunk> chunks;
+    std::vector<size_t> missing;  // Scratch for update()
+
+    ThreadPool pager;
+    std::mutex pagedMutex;
+    std::deque<PagedChunk> paged;  // Read from disk, waiting for upload
+
+    size_t cpuBytes = 0;  // Paged in, not yet uploaded
+    size_t gpuBytes = 0;
+    size_t inFlight = 0;
+    size_t residentCount = 0;
+    size_t triangleCount = 0;
+    uint64_t frame = 0;
+
+    void uploadPaged(size_t uploadBudget);
+    void request(size_t chunk);
+    // Evicts the least recently visible chunk not visible this frame
+    bool evictOne();
+};
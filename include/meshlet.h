@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+#include "frustum.h"
+#include "mesh.h"
+
+const unsigned int MESHLET_MAX_VERTICES = 64;
+const unsigned int MESHLET_MAX_TRIANGLES = 124;
+
+// Camera state in a mesh's local space for meshlet culling
+struct MeshletCullContext {
+    Frustum frustum;
+    glm::vec3 cameraPosition;
+    bool insideFrustum = false;  // The whole mesh is in view, only the normal cones need a test
+};
+
+// Splits every level of detail into runs of consecutive triangles that touch
+// at most MESHLET_MAX_VERTICES vertices, so a meshlet is just an index range.
+// The index order is not changed, so run this after any reordering.
+std::vector<Meshlet> buildMeshlets(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                   const std::vector<MeshLod>& lods);
+
+// False when the meshlet is outside the frustum or all its triangles face away
+bool isMeshletVisible(const Meshlet& meshlet, const MeshletCullContext& context);
@@ -5,18 +5,144 @@
 #include <assimp/Importer.hpp>
 #include <assimp/scene.h>
 #include <assimp/postprocess.h>
+#include <atomic>
 #include <string>
 #include <vector>
 #include <map>
+#include <unordered_map>
+#include <memory>
+#include "bounds_cull.h"
 #include "mesh.h"
+#include "mesh_optimizer.h"
+#include "load_report.h"
+#include "mesh_streamer.h"
+#include "scene_graph.h"
+#include "texture_streamer.h"
+#include "vertex_convert.h"
 #include "shader.h"
 
+class MeshCache;
+struct MeshCacheKey;
+class TextureCache;
+
+// Shared between a background import and the thread that watches it
+struct LoadProgress {
+    std::atomic<float> fraction{0.0f};
+    std::atomic<const char*> stage{"Queued"};
+    std::atomic<bool> cancelRequested{false};
+};
+
+// Named Assimp post-process pipelines, trading import-time validation for speed.
+// Tangents are never requested since Vertex has nowhere to store them.
+enum class ImportProfile : unsigned int {
+    FastPreview,    // Triangulate, normals, UV flip, pre-transform and vertex welding only
+    Balanced,       // Plus UV generation, invalid data removal and mesh merging
+    FullValidation  // Plus structure validation and in-facing normal repair
+};
+
+const char* importProfileName(ImportProfile profile);
+
+struct ModelLoadOptions {
+    // Assimp post-processing to request, part of the mesh cache key
+    ImportProfile importProfile = ImportProfile::FullValidation;
+    // Keep the node hierarchy instead of flattening it with PreTransformVertices.
+    // A mesh several nodes reference is stored once and drawn instanced with each
+    // node's transform; a mesh referenced once gets its transform baked in.
+    bool instancing = false;
+    // Convert meshes on a worker pool instead of the calling thread
+    bool parallelConversion = true;
+    // Worker count for parallel conversion, 0 = one per hardware thread
+    unsigned int workerThreads = 0;
+    // Time the conversion stage at 1, 2, 4, ... workers and print the speedup,
+    // then time vertex interleaving on the scalar and SIMD paths
+    bool benchmarkConversion = false;
+    // GPU vertex layout, Quantized halves vertex memory
+    VertexFormat vertexFormat = VertexFormat::Full;
+    // Reorder triangles for the post-transform cache and overdraw, and
+    // vertices for fetch locality, during conversion
+    bool optimizeMeshes = true;
+    // Simplified levels of detail built per mesh, 0 disables
+    unsigned int lodLevels = 4;
+    // Stop simplifying once the error would exceed this fraction of a mesh's radius
+    float lodMaxError = 0.05f;
+    // Split meshes into meshlets with bounds for per-frame culling
+    bool buildMeshlets = true;
+    // Free the Assimp importer and scene after import, and each mesh's CPU
+    // vertex and index copies once they are on the GPU; only bounds, levels,
+    // meshlets and materials stay resident
+    bool leanMemory = false;
+    // Hash every mesh after import so a hot reload can replace only the
+    // meshes whose contents changed
+    bool hashMeshes = false;
+    // Encode textures to BC1/BC3/BC4/BC5 on load
+    bool compressTextures = false;
+    CompressionQuality compressionQuality = CompressionQuality::Fast;
+    // Keep decoded mip chains (or compressed images) in a "texture_cache"
+    // folder next to the model, warm loads map them instead of decoding
+    bool cacheTextures = true;
+    // Only import in the constructor; the caller uploads later with upload()
+    // on the thread that owns the GL context
+    bool deferUpload = false;
+    // Stream geometry from the mesh cache entry instead of keeping every mesh
+    // in memory; the first load of a file still imports it whole to build the entry
+    bool outOfCore = false;
+    StreamingBudget streamingBudget;
+    // Where mesh cache entries are read and written, relative to the working directory
+    std::string meshCacheDirectory = "cache";
+    // Off forces a fresh import and leaves the cache untouched
+    bool useMeshCache = true;
+    // Per-stage timings are written here as JSON once the load completes, empty disables
+    std::string reportDirectory = "load_reports";
+    // Optional progress/cancellation channel, must outlive the constructor
+    LoadProgress* progress = nullptr;
+};
+
 class Model {
 public:
-    Model(const char* path);
+    Model(const char* path, const ModelLoadOptions& options = ModelLoadOptions());
     ~Model();
-    void Draw(Shader &shader);
+
+    // Assimp flags the import of path uses, and the mesh cache key it would load
+    // from with these options; false if the file does not exist
+    static unsigned int importFlagsFor(const std::string& path, ImportProfile profile, bool instancing = false);
+    static bool makeCacheKey(const std::string& path, const ModelLoadOptions& options, MeshCacheKey& key);
+
+    // Draws every mesh at full detail, or at the level view selects with its
+    // back-facing and off-screen meshlets culled. Out-of-core models also page
+    // geometry in and out for the view, so they need one to draw anything.
+    void Draw(Shader &shader, const DrawView* view = nullptr);
     bool isValid() const { return m_isValid; }
+    // True when the geometry came from the mesh cache instead of Assimp
+    bool isFromCache() const { return fromCache; }
+    const std::string& getSourcePath() const { return sourcePath; }
+    const ModelLoadOptions& getOptions() const { return options; }
+
+    // Hot reload: takes the meshes of a fresh, not yet uploaded import of the
+    // same file whose hashes differ and re-uploads them into the existing GL
+    // buffers. False, leaving this model untouched, when the mesh layout changed
+    // (or either model streams out of core) and the fresh model must replace it.
+    bool replaceChangedMeshes(Model& fresh);
+    // Re-decodes an image file this model's textures were loaded from
+    bool reloadTexture(const std::string& file);
+
+    // Creates GL resources for imported meshes until roughly byteBudget bytes of
+    // geometry were uploaded. Returns true once every mesh is on the GPU.
+    bool upload(size_t byteBudget = std::numeric_limits<size_t>::max());
+    bool isUploaded() const { return pendingMeshes.empty(); }
+    // Streams decoded texture pixels to the GPU, call once per frame on the GL thread
+    void streamTextures(size_t byteBudget);
+    size_t getPendingTextureCount() const;
+    // GPU memory of the textures uploaded so far
+    size_t getTextureBytes() const;
+    // nullptr until the first texture is requested
+    const TextureStreamer* getTextureStreamer() const;
+    // Distinct image files the materials resolved to, known right after import
+    std::vector<std::string> getTextureFiles() const;
+    // How this model's textures are decoded and cached
+    TextureStreamSettings getTextureSettings() const;
+    float getUploadProgress() const {
+        return pendingMeshes.empty() ? 1.0f : static_cast<float>(nextUpload) / pendingMeshes.size();
+    }
 
     // Add getters for model dimensions
     glm::vec3 getCenter() const { return (maxBounds + minBounds) * 0.5f; }
@@ -25,25 +151,122 @@ public:
     glm::vec3 getMaxBounds() const { return maxBounds; }
     std::string getFilename() const { return filename; }
 
+    // GPU vertex memory, and what the uncompressed 32-byte layout would need
+    size_t getVertexBytes() const;
+    size_t getFullVertexBytes() const;
+    // GPU index memory, and how much of it 16-bit index buffers saved
+    size_t getIndexBytes() const;
+    size_t getIndexBytesSaved() const;
+    // Instancing against the flattened scene: distinct meshes and the copies a
+    // flattened import would hold, draw calls for each, and the GPU geometry of
+    // each (the instanced one including its transform buffers)
+    size_t getMeshCount() const { return meshes.size(); }
+    size_t getInstanceCount() const;
+    size_t getInstanceBytes() const;
+    size_t getFlattenedGeometryBytes() const;
+    size_t getDrawCallCount() const { return drawCalls; }
+    // Frustum culling of whole meshes by the last Draw, in-memory models only
+    size_t getCulledMeshCount() const { return culledMeshes; }
+    double getMeshCullMilliseconds() const { return cullMilliseconds; }
+    // Node hierarchy kept by an instanced import, empty otherwise. Moving a
+    // node with getSceneGraph().setLocalTransform moves its subtree on the next Draw.
+    SceneGraph& getSceneGraph() { return sceneGraph; }
+    const SceneGraph& getSceneGraph() const { return sceneGraph; }
+    // Pushes the top-level parts away from the center by amount times their
+    // distance from it; only for instanced models held in memory
+    void setExplodeAmount(float amount);
+    float getExplodeAmount() const { return explodeAmount; }
+    bool canExplode() const { return !streamer && sceneGraph.getNodeCount() > 1; }
+    // Full-detail triangles over every instance, how many the last Draw submitted, and how many
+    // of the selected levels' triangles meshlet culling skipped
+    size_t getTriangleCount() const;
+    size_t getDrawnTriangleCount() const { return drawnTriangles; }
+    size_t getCulledTriangleCount() const { return culledTriangles; }
+    // Out-of-core residency, nullptr for models held in memory
+    const MeshStreamer* getStreamer() const { return streamer.get(); }
+    void setStreamingBudget(const StreamingBudget& budget);
+    // Stage timings of this load; complete once every mesh and texture is uploaded
+    const LoadReport& getLoadReport() const { return loadReport; }
+    // Vertex cache efficiency summed over all meshes, only known after a fresh import
+    bool hasVertexCacheStats() const { return cacheStatsAfter.triangles > 0; }
+    const VertexCacheStats& getVertexCacheStatsBefore() const { return cacheStatsBefore; }
+    const VertexCacheStats& getVertexCacheStatsAfter() const { return cacheStatsAfter; }
+
 private:
     std::vector<Mesh> meshes;
+    std::vector<MeshData> pendingMeshes;  // Imported but not yet uploaded
+    size_t nextUpload = 0;
+    size_t drawnTriangles = 0;
+    size_t culledTriangles = 0;
+    size_t drawCalls = 0;
+    size_t culledMeshes = 0;
+    double cullMilliseconds = 0.0;
+    // Model-space box and sphere of every uploaded mesh, and the last frame's CullResult of each
+    BoundsArrays meshBounds;
+    std::vector<uint8_t> meshVisibility;
+    // Node hierarchy of an instanced import, the meshes follow its world transforms
+    SceneGraph sceneGraph;
+    // Top-level parts the explode view moves, with their original local transforms
+    // and offset directions in their parent's space
+    float explodeAmount = 0.0f;
+    std::vector<uint32_t> explodeParts;
+    std::vector<glm::mat4> explodeBase;
+    std::vector<glm::vec3> explodeDirections;
+    std::string sourcePath;
     std::string directory;
     std::string filename;
     bool m_isValid = false;
-    std::vector<Texture> textures_loaded;
-    Assimp::Importer importer;  // Keep importer alive
+    bool fromCache = false;
+    ModelLoadOptions options;
+    LoadReport loadReport;  // Declared before textureCache, whose decode jobs record into it
+    std::unique_ptr<TextureCache> textureCache;  // Created on the GL thread
+    std::unique_ptr<MeshStreamer> streamer;      // Out-of-core geometry
+    // Material texture path -> file on disk, files with identical contents share one entry
+    std::unordered_map<std::string, std::string> textureFiles;
+    // Parsed textures/colors per material index, materials are shared between meshes
+    std::map<unsigned int, std::vector<Texture>> materialCache;
+    std::unique_ptr<Assimp::Importer> importer;  // Owns scene, freed after import in lean mode
     const aiScene* scene = nullptr;  // Store the scene for texture loading
 
+    // Content hash per mesh in upload order, filled when options.hashMeshes is set
+    std::vector<uint64_t> meshHashes;
+
+    // Summed over all meshes by convertMeshes
+    VertexCacheStats cacheStatsBefore;
+    VertexCacheStats cacheStatsAfter;
+
     // Bounding box information
     glm::vec3 minBounds = glm::vec3(std::numeric_limits<float>::max());
     glm::vec3 maxBounds = glm::vec3(std::numeric_limits<float>::lowest());
 
     bool loadModel(std::string path);
+    bool loadFromCache(const MeshCache& meshCache, const MeshCacheKey& key);
+    bool openStreamer(const MeshCache& meshCache, const MeshCacheKey& key);
     void processNode(aiNode *node, const aiScene *scene);
-    Mesh processMesh(aiMesh *mesh, const aiScene *scene);
-    std::vector<Vertex> getVertices(aiMesh *mesh);
-    std::vector<unsigned int> getIndices(aiMesh *mesh);
-    std::vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName);
-    unsigned int TextureFromFile(const char *path, const std::string &directory);
-    void updateBounds(const glm::vec3& point);
+    void collectMeshes(aiNode *node, const aiScene *scene, std::vector<aiMesh*>& out);
+    // Adds the node's subtree to sceneGraph and records the nodes referencing each scene mesh,
+    // indexed like scene->mMeshes
+    void collectInstances(aiNode *node, int32_t parent, std::vector<std::vector<uint32_t>>& out);
+    // instances is empty for a flattened scene, otherwise one transform list per mesh
+    std::vector<MeshData> convertMeshes(const std::vector<aiMesh*>& sceneMeshes, unsigned int threads,
+                                        LoadReport* report,
+                                        const std::vector<std::vector<glm::mat4>>& instances = {});
+    void drawMesh(Mesh& mesh, Shader& shader, const DrawView* view, const MeshletCullContext* cull);
+    // Refits mesh i's entry in meshBounds to its current instances
+    void updateMeshBounds(size_t i);
+    void findExplodeParts();
+    void finishLoadReport();
+    void computeMeshHashes();
+    void releaseImportData();
+    void benchmarkConversion(const std::vector<aiMesh*>& sceneMeshes);
+    void processMesh(aiMesh *mesh, const aiScene *scene, MeshData& data);
+    const std::vector<Texture>& getMaterialTextures(unsigned int materialIndex, const aiScene *scene);
+    void resolveTextureFiles();
+    static std::vector<Vertex> getVertices(aiMesh *mesh, glm::vec3& meshMin, glm::vec3& meshMax);
+    static VertexStreams getVertexStreams(aiMesh *mesh);
+    static std::vector<unsigned int> getIndices(aiMesh *mesh);
+    std::vector<Texture> loadMaterialTextures(aiMaterial *mat, aiTextureType type, const std::string& typeName);
+    unsigned int TextureFromFile(const char *path);
+    bool cancelled() const { return options.progress && options.progress->cancelRequested; }
+    void reportProgress(const char* stage, float fraction) const;
 }; 
\ No newline at end of file
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include "model.h"
+
+// Imports a model on a background thread. The finished Model still has to be
+// uploaded on the GL thread (Model::upload) before it can be drawn.
+class ModelLoader {
+public:
+    ModelLoader(std::string path, const ModelLoadOptions& options = ModelLoadOptions());
+    ~ModelLoader();
+
+    ModelLoader(const ModelLoader&) = delete;
+    ModelLoader& operator=(const ModelLoader&) = delete;
+
+    void cancel() { progress.cancelRequested = true; }
+    bool isCancelled() const { return progress.cancelRequested; }
+    bool isFinished() const { return finished; }
+
+    float getProgress() const { return progress.fraction; }
+    const char* getStage() const { return progress.stage; }
+    const std::string& getPath() const { return path; }
+
+    // Hands over the imported model once isFinished(), null if the import failed
+    std::unique_ptr<Model> takeModel();
+
+private:
+    std::string path;
+    LoadProgress progress;
+    std::unique_ptr<Model> model;
+    std::atomic<bool> finished{false};
+    std::thread worker;
+};
@@ -8,11 +8,14 @@
 #include <string>
 #include "camera.h"
 #include "shader.h"
+#include "file_watcher.h"
 #include "model.h"
+#include "model_loader.h"
 #include "imgui.h"
 #include "imgui_impl_glfw.h"
 #include "imgui_impl_opengl3.h"
 #include <memory>
+#include <vector>
 
 class Renderer {
 public:
@@ -26,6 +29,15 @@ private:
     GLFWwindow* window;
     Camera camera;
     std::unique_ptr<Model> model;
+    std::unique_ptr<ModelLoader> loader;  // Background import in flight
+    std::unique_ptr<Model> pendingModel;  // Imported, uploading over several frames
+    bool loadFailed = false;
+    bool framePendingModel = true;        // False when pendingModel is a hot reload, keep the camera
+    ModelLoadOptions loadOptions;         // Applied to the next load
+    bool hotReload = false;               // Re-import the displayed model when its files change
+    std::unique_ptr<FileWatcher> watcher;     // Model file and its textures
+    std::unique_ptr<ModelLoader> reloader;    // Background re-import of the displayed model
+    std::vector<std::unique_ptr<ModelLoader>> retiredLoaders;  // Cancelled, destroyed once their thread exits
     std::unique_ptr<Shader> shader;
     glm::vec3 modelScale;  // Store model scale factor
     glm::vec3 rotationCenter;  // Point to orbit around
@@ -47,12 +59,21 @@ private:
     bool firstMouse;
     float deltaTime;
     float lastFrame;
+    float frameTime;  // Smoothed, in milliseconds
+    float lodPixelError;  // Screen-space error allowed when picking a level of detail
+    bool cullMeshlets;
+    bool cullMeshes;
 
     void initGLFW();
     void initGLAD();
     void initImGui();
     void processInput();
     void renderUI();
+    void updateLoading();
+    void updateHotReload();
+    void retireLoader(std::unique_ptr<ModelLoader>& retired);
+    void watchModel();
+    void onModelReady();
     void cleanup();
     std::string openFileDialog();
 
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+
+// Node hierarchy with local and world transforms in flat arrays, one per
+// field. Nodes are stored in topological order (every parent before its
+// children), so a single forward pass can propagate transforms, and update()
+// only recomputes nodes whose local transform changed plus their descendants.
+class SceneGraph {
+public:
+    static constexpr int32_t NO_PARENT = -1;
+
+    // parent must be NO_PARENT or an existing node, which keeps the order
+    // topological. Returns the new node's index.
+    uint32_t addNode(int32_t parent, const glm::mat4& local);
+    void clear();
+    void reserve(size_t count);
+
+    size_t getNodeCount() const { return parents.size(); }
+    int32_t getParent(uint32_t node) const { return parents[node]; }
+    const glm::mat4& getLocalTransform(uint32_t node) const { return locals[node]; }
+    // As of the last update()
+    const glm::mat4& getWorldTransform(uint32_t node) const { return worlds[node]; }
+    void setLocalTransform(uint32_t node, const glm::mat4& local);
+
+    // Recomputes the world transforms of dirty subtrees, returns how many changed
+    size_t update();
+    // Whether the update() that produced the current version recomputed the node
+    bool wasUpdated(uint32_t node) const { return updated[node] != 0; }
+    // Bumped by every update() that changed a node, so users of world
+    // transforms can tell whether they missed one
+    uint64_t getVersion() const { return version; }
+    size_t getLastUpdateCount() const { return lastUpdateCount; }
+    double getLastUpdateMilliseconds() const { return lastUpdateMilliseconds; }
+
+    // For serialization
+    const std::vector<int32_t>& getParents() const { return parents; }
+    const std::vector<glm::mat4>& getLocalTransforms() const { return locals; }
+
+private:
+    std::vector<int32_t> parents;
+    std::vector<glm::mat4> locals;
+    std::vector<glm::mat4> worlds;
+    std::vector<uint8_t> dirty;    // Local transform set since the last update
+    std::vector<uint8_t> updated;  // Recomputed by the last update
+    std::vector<uint32_t> batch;   // Nodes the last update recomputed, in order
+    size_t firstDirty = SIZE_MAX;  // Nodes before it are clean and need no look
+    uint64_t version = 0;
+    size_t lastUpdateCount = 0;
+    double lastUpdateMilliseconds = 0.0;
+};
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include "texture_streamer.h"
+
+// Reference-counted GL textures keyed by resolved file name. Every mesh of a
+// model that references the same image shares one decode and one upload.
+// Must be created and used on the GL thread.
+class TextureCache {
+public:
+    explicit TextureCache(const TextureStreamSettings& settings = TextureStreamSettings());
+    ~TextureCache();
+
+    TextureCache(const TextureCache&) = delete;
+    TextureCache& operator=(const TextureCache&) = delete;
+
+    // Returns the texture for filename, requesting a decode on first use
+    unsigned int acquire(const std::string& filename);
+    // Drops one reference, the texture is deleted with the last one
+    void release(unsigned int textureId);
+    // Re-decodes a file already in the cache into its texture, false if unknown
+    bool reload(const std::string& filename);
+
+    TextureStreamer& getStreamer() { return streamer; }
+    size_t size() const { return entries.size(); }
+    size_t getHits() const { return hits; }
+
+private:
+    struct Entry {
+        std::string filename;
+        size_t refs = 0;
+    };
+
+    TextureStreamer streamer;
+    std::unordered_map<std::string, unsigned int> idsByFile;
+    std::unordered_map<unsigned int, Entry> entries;
+    size_t hits = 0;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "texture_mips.h"
+
+class ThreadPool;
+
+// EXT_texture_compression_s3tc + EXT_texture_sRGB, the core 3.3 loader
+// doesn't define them but every desktop driver supports them
+const GLenum COMPRESSED_SRGB_S3TC_DXT1 = 0x8C4C;
+const GLenum COMPRESSED_SRGB_ALPHA_S3TC_DXT5 = 0x8C4F;
+
+enum class CompressionQuality {
+    Fast,  // Bounding-box endpoints
+    High   // Principal-axis endpoints refined by least squares
+};
+
+// Block-compressed image with its full mip chain, ready for glCompressedTexImage2D
+struct CompressedImage {
+    GLenum format = 0;
+    int width = 0;
+    int height = 0;
+    std::vector<std::vector<unsigned char>> mips;  // Level 0 first
+};
+
+// BC1 for RGB, BC3 for RGBA (both sRGB), BC4 for R, BC5 for RG
+GLenum compressedFormatFor(int components);
+
+// Compresses 8-bit pixels with 1-4 components, including the mip chain from
+// buildMipChain. Block rows are spread over pool when one is given.
+void compressImage(const unsigned char* pixels, int width, int height, int components,
+                   CompressionQuality quality, CompressedImage& out, ThreadPool* pool = nullptr);
+
+// Single-block encoders; rgba is 4x4 pixels in row order, values one channel
+void encodeBC1(const unsigned char rgba[64], unsigned char out[8], CompressionQuality quality);
+void encodeBC4(const unsigned char values[16], unsigned char out[8]);
+
+// Persisted compressed images, so each texture is encoded once. Loading fails
+// when the file was built from another version of source.
+bool loadCompressedImage(const std::string& path, CompressedImage& image, const SourceStamp& source);
+bool saveCompressedImage(const std::string& path, const CompressedImage& image, const SourceStamp& source);
+// Whether path holds an image built from source, reading only its header
+bool compressedImageMatches(const std::string& path, const SourceStamp& source);
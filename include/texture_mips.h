@@ -0,0 +1,64 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "mapped_file.h"
+
+class ThreadPool;
+
+// Size and timestamp of the image a cache file was built from. Cache files
+// are named after the image alone and hold its stamp, so an edited image
+// overwrites its old file instead of adding another one.
+struct SourceStamp {
+    uint64_t size = 0;
+    int64_t modified = 0;
+
+    bool operator==(const SourceStamp& other) const { return size == other.size && modified == other.modified; }
+};
+
+// Decoded 8-bit image with every mip level down to 1x1, level 0 first
+struct MipChain {
+    int width = 0;
+    int height = 0;
+    int components = 0;
+    std::vector<std::vector<unsigned char>> levels;
+};
+
+inline int mipDimension(int size, size_t level) {
+    return std::max(1, size >> level);
+}
+
+// Builds the chain with a separable [1 3 3 1] tent filter. The color channels
+// of 3 and 4 component images are sRGB and are filtered in linear space.
+// Rows of each level are spread over pool when one is given.
+void buildMipChain(const unsigned char* pixels, int width, int height, int components,
+                   MipChain& out, ThreadPool* pool = nullptr);
+
+bool saveMipChain(const std::string& path, const MipChain& chain, const SourceStamp& source);
+// Whether path holds a chain built from source, reading only its header
+bool mipChainMatches(const std::string& path, const SourceStamp& source);
+
+// A saved chain mapped read-only, levels point straight into the mapping
+class MappedMipChain {
+public:
+    // False if the file is missing, damaged or was built from another version of source
+    bool open(const std::string& path, const SourceStamp& source);
+    bool isOpen() const { return file.isOpen(); }
+
+    int getWidth() const { return width; }
+    int getHeight() const { return height; }
+    int getComponents() const { return components; }
+    size_t getLevelCount() const { return levels.size(); }
+    const unsigned char* getLevel(size_t level) const { return levels[level]; }
+    size_t getFileBytes() const { return file.size(); }
+
+private:
+    MappedFile file;
+    int width = 0;
+    int height = 0;
+    int components = 0;
+    std::vector<const unsigned char*> levels;
+};
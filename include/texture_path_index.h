@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+
+// Resolves material texture paths. A path that names an existing file, absolute
+// or relative to the model folder, costs one probe. Only the first miss lists
+// the folders textures are searched in, after which every lookup is a hash
+// lookup instead of a round of failed file opens: the relative path
+// case-insensitively, then the file name alone. Results, including misses, are cached.
+class TexturePathIndex {
+public:
+    // Searches modelDirectory and modelDirectory/../Textures, the model folder
+    // wins when both contain the same relative path
+    explicit TexturePathIndex(const std::string& modelDirectory);
+
+    // Path of the matching file, empty if there is none
+    std::string resolve(const std::string& texturePath);
+
+    // Zero until a lookup needed the index
+    size_t getFileCount() const { return fileCount; }
+
+private:
+    static constexpr int MAX_DEPTH = 4;
+    static constexpr size_t MAX_FILES = 200000;
+
+    std::unordered_map<std::string, std::string> byRelativePath;  // Lowercase, '/' separated
+    std::unordered_map<std::string, std::string> byName;          // Lowercase file name
+    std::unordered_map<std::string, std::string> results;         // Query -> file, "" for misses
+    std::string modelDirectory;
+    bool indexed = false;
+    size_t fileCount = 0;
+
+    void buildIndex();
+    void indexFolder(const std::string& root);
+    static std::string normalize(const std::string& path);
+};
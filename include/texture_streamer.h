@@ -0,0 +1,136 @@
+#pragma once
+
+#include <glad/glad.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include "load_report.h"
+#include "texture_compress.h"
+#include "texture_mips.h"
+#include "thread_pool.h"
+
+struct TextureStreamSettings {
+    // Encode decoded images to BCn before upload, cutting texture memory 4-8x
+    bool compress = false;
+    CompressionQuality quality = CompressionQuality::Fast;
+    // Decoded mip chains (or BCn images when compressing) are persisted here so
+    // warm loads skip decoding; empty disables the on-disk cache
+    std::string cacheDirectory;
+};
+
+// Decodes image files on worker threads, builds their mip chains on the CPU and
+// streams the levels to the GPU through pixel buffer objects, a bounded number
+// of bytes per frame. Every streamer shares one process-wide decode pool and
+// one filter pool, so several loaded models don't multiply the threads. Chains found in the cache directory are memory-mapped
+// and uploaded straight from the mapping. Everything except the decode itself
+// must be called on the GL thread.
+class TextureStreamer {
+public:
+    explicit TextureStreamer(const TextureStreamSettings& settings = TextureStreamSettings());
+    ~TextureStreamer();
+
+    TextureStreamer(const TextureStreamer&) = delete;
+    TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // Creates a texture holding a 1x1 white placeholder and queues the file for
+    // decoding. The returned id stays valid, the real image replaces the placeholder.
+    unsigned int request(const std::string& filename);
+    // Decodes filename again into an existing texture, e.g. after it changed on disk
+    void reload(unsigned int textureId, const std::string& filename);
+
+    // Uploads decoded pixels until byteBudget bytes were copied this call.
+    // Large levels are split across calls a few rows at a time.
+    void pump(size_t byteBudget);
+    // Blocks until every requested texture is decoded and uploaded
+    void finish();
+
+    size_t pendingCount() const;
+    // GPU memory of the textures uploaded so far, all mip levels included
+    size_t getTextureBytes() const { return textureBytes; }
+    // Stops counting a texture that was deleted; decodes still queued for it
+    // are dropped instead of uploaded into a texture that reuses the name
+    void forget(unsigned int textureId);
+
+    // Decodes filename and writes the cache file a later request would map,
+    // without touching GL. Files already built from this version of filename
+    // are kept unless force is set; skipped reports whether that happened. False if the image can't be decoded or saved.
+    static bool bake(const std::string& filename, const TextureStreamSettings& settings, bool force,
+                     ThreadPool* pool, bool* skipped = nullptr);
+
+    // Decode, cache and upload stages are recorded here; must outlive the streamer
+    void setReport(LoadReport* loadReport) { report = loadReport; }
+
+    // On-disk cache use since construction
+    size_t getCacheHits() const { return cacheHits; }
+    size_t getCacheMisses() const { return cacheMisses; }
+    size_t getCacheBytesRead() const { return cacheBytesRead; }
+
+private:
+    struct DecodedImage {
+        unsigned int textureId = 0;
+        uint64_t generation = 0;      // Of the request, see latestRequest
+        std::string filename;
+        int width = 0;
+        int height = 0;
+        int components = 0;
+        MipChain mips;                // Decoded and filtered this load
+        MappedMipChain mapped;        // Or mapped from the cache
+        CompressedImage compressed;   // Or block compressed
+        size_t levelsUploaded = 0;
+        int rowsUploaded = 0;         // Of the level being uploaded
+
+        size_t levelCount() const;
+        const unsigned char* level(size_t index) const;
+    };
+
+    static constexpr int PBO_COUNT = 3;
+
+    // Shared with the jobs queued on the process-wide pool, which may only
+    // start after this streamer is gone
+    struct DecodeQueue {
+        std::mutex mutex;
+        std::condition_variable changed;
+        std::deque<std::unique_ptr<DecodedImage>> ready;  // Decoded, waiting for upload
+        size_t running = 0;
+        std::atomic<bool> cancelled{false};  // Set on destruction, queued decodes are skipped
+    };
+
+    TextureStreamSettings settings;
+    std::shared_ptr<DecodeQueue> queue;
+    std::unique_ptr<DecodedImage> current;             // Partially uploaded
+    size_t requested = 0;
+    size_t completed = 0;
+
+    unsigned int pbos[PBO_COUNT] = {};
+    size_t pboSizes[PBO_COUNT] = {};
+    int nextPbo = 0;
+
+    // Newest request per live texture. Older ones and those of forgotten
+    // textures are skipped when they reach the front of the queue.
+    std::unordered_map<unsigned int, uint64_t> latestRequest;
+    uint64_t nextGeneration = 0;
+
+    std::unordered_map<unsigned int, size_t> bytesByTexture;
+    size_t textureBytes = 0;
+
+    LoadReport* report = nullptr;
+    std::atomic<size_t> cacheHits{0};
+    std::atomic<size_t> cacheMisses{0};
+    std::atomic<size_t> cacheBytesRead{0};
+
+    void queueDecode(unsigned int textureId, const std::string& filename);
+    void decode(DecodedImage& image);
+    // Empty if there is no cache directory or filename can't be read
+    static std::string cachePath(const TextureStreamSettings& settings, const std::string& filename,
+                                 SourceStamp& source);
+    bool beginUpload(DecodedImage& image);
+    size_t uploadRows(DecodedImage& image, size_t byteBudget);
+    size_t uploadMips(DecodedImage& image, size_t byteBudget);
+    void finishUpload(DecodedImage& image);
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Fixed-size pool of worker threads fed from a single FIFO queue
+class ThreadPool {
+public:
+    // 0 threads means one per hardware thread
+    explicit ThreadPool(unsigned int threadCount = 0);
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    void submit(std::function<void()> task);
+    // Blocks until the queue is empty and every worker is idle
+    void wait();
+    // Runs fn(i) for every i in [0, count) across the workers and blocks until done.
+    // Indices are handed out dynamically, so uneven work still balances. The first
+    // exception thrown by fn is rethrown on the calling thread.
+    void parallelFor(size_t count, const std::function<void(size_t)>& fn);
+
+    unsigned int size() const { return static_cast<unsigned int>(workers.size()); }
+    static unsigned int hardwareThreads();
+
+private:
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> tasks;
+    std::mutex mutex;
+    std::condition_variable taskAvailable;
+    std::condition_variable idle;
+    size_t activeTasks = 0;
+    bool stopping = false;
+
+    void workerLoop();
+};
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstddef>
+#include <glm/glm.hpp>
+#include "mesh.h"
+
+// Tightly packed xyz float streams, as Assimp stores them (aiVector3D)
+struct VertexStreams {
+    const float* positions = nullptr;
+    const float* normals = nullptr;    // Optional, zero when missing
+    const float* texCoords = nullptr;  // Optional, only xy is used
+};
+
+enum class VertexConvertPath {
+    Scalar,
+    SSE2,
+    AVX
+};
+
+// Widest path the compiler and the running CPU both support
+VertexConvertPath bestVertexConvertPath();
+const char* vertexConvertPathName(VertexConvertPath path);
+
+// Interleaves count vertices into dst, which must already hold count elements,
+// and grows minBounds/maxBounds by every position in the same pass
+void convertVertices(const VertexStreams& src, size_t count, Vertex* dst,
+                     glm::vec3& minBounds, glm::vec3& maxBounds,
+                     VertexConvertPath path = bestVertexConvertPath());
@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <glm/glm.hpp>
+#include "mesh.h"
+
+// 16-byte compressed vertex, decoded in phong.vert:
+// position normalized to the mesh AABB, octahedral normal, half-float UVs
+struct PackedVertex {
+    uint16_t position[4];  // unorm16 xyz, w unused
+    int16_t normal[2];     // snorm16 octahedral
+    uint16_t texCoords[2]; // IEEE half
+};
+
+static_assert(sizeof(PackedVertex) == 16, "PackedVertex must stay 16 bytes");
+
+uint16_t floatToHalf(float value);
+// Maps a unit vector onto the [-1, 1]^2 octahedron
+glm::vec2 octEncode(const glm::vec3& normal);
+
+// Quantizes positions relative to [minBounds, maxBounds]
+void quantizeVertices(const std::vector<Vertex>& vertices, const glm::vec3& minBounds,
+                      const glm::vec3& maxBounds, std::vector<PackedVertex>& out);
+// Same, into count preallocated slots (e.g. a mapped vertex buffer)
+void quantizeVertices(const Vertex* vertices, size_t count, const glm::vec3& minBounds,
+                      const glm::vec3& maxBounds, PackedVertex* out);
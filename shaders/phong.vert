@@ -3,6 +3,7 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aNormal;
 layout (location = 2) in vec2 aTexCoords;
+layout (location = 3) in mat4 aInstance;
 
 out vec3 FragPos;
 out vec3 Normal;
@@ -12,11 +13,33 @@ uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
 
+// Compressed vertices: aPos is unorm16 within the mesh bounds,
+// aNormal.xy is an snorm16 octahedral normal
+uniform bool quantized;
+uniform vec3 positionOffset;
+uniform vec3 positionScale;
+
+// Instanced meshes: aInstance places each copy within the model
+uniform bool instanced;
+
+vec3 octDecode(vec2 e)
+{
+    vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+    float t = max(-n.z, 0.0);
+    n.x += n.x >= 0.0 ? -t : t;
+    n.y += n.y >= 0.0 ? -t : t;
+    return normalize(n);
+}
+
 void main()
 {
-    FragPos = vec3(model * vec4(aPos, 1.0));
-    Normal = mat3(transpose(inverse(model))) * aNormal;
+    vec3 position = quantized ? positionOffset + aPos * positionScale : aPos;
+    vec3 normal = quantized ? octDecode(aNormal.xy) : aNormal;
+
+    mat4 world = instanced ? model * aInstance : model;
+    FragPos = vec3(world * vec4(position, 1.0));
+    Normal = mat3(transpose(inverse(world))) * normal;
     TexCoords = aTexCoords;
     
     gl_Position = projection * view * vec4(FragPos, 1.0);
-} 
\ No newline at end of file
+}
@@ -0,0 +1,86 @@
+#include "allocation_counter.h"
+
+#ifdef PGV_COUNT_ALLOCATIONS
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+// Per thread, so stages on worker threads only see their own allocations
+thread_local uint64_t threadAllocations = 0;
+thread_local uint64_t threadAllocatedBytes = 0;
+
+void* countedAllocate(std::size_t size) noexcept {
+    threadAllocations++;
+    threadAllocatedBytes += size;
+    return std::malloc(size > 0 ? size : 1);
+}
+
+} // namespace
+
+void* operator new(std::size_t size) {
+    if (void* memory = countedAllocate(size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) {
+    if (void* memory = countedAllocate(size)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept {
+    return countedAllocate(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+bool allocationCountingEnabled() {
+    return true;
+}
+
+uint64_t getThreadAllocationCount() {
+    return threadAllocations;
+}
+
+uint64_t getThreadAllocatedBytes() {
+    return threadAllocatedBytes;
+}
+
+#else
+
+bool allocationCountingEnabled() {
+    return false;
+}
+
+uint64_t getThreadAllocationCount() {
+    return 0;
+}
+
+uint64_t getThreadAllocatedBytes() {
+    return 0;
+}
+
+#endif
@@ -0,0 +1,452 @@
+// Headless preprocessor for model libraries. Imports every model under a
+// directory through the same pipeline as the viewer and writes the mesh cache
+// entries and texture cache files it reads, so viewer sessions start warm.
+// No window or GL context is created.
+
+#include "log.h"
+#include "mesh_cache.h"
+#include "model.h"
+#include "texture_streamer.h"
+#include "thread_pool.h"
+#include <assimp/Importer.hpp>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cctype>
+#include <cstdlib>
+#include <filesystem>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+struct BakeOptions {
+    std::string root;
+    bool watch = false;
+    int intervalSeconds = 2;
+    unsigned int threads = 0;
+    bool force = false;
+    bool textures = true;
+    bool compareProfiles = false;
+    ModelLoadOptions load;
+};
+
+struct BakeStats {
+    std::atomic<size_t> imported{0};
+    std::atomic<size_t> upToDate{0};
+    std::atomic<size_t> failed{0};
+    std::atomic<size_t> texturesBaked{0};
+    std::atomic<size_t> texturesUpToDate{0};
+    std::atomic<size_t> texturesFailed{0};
+
+    void reset() {
+        imported = upToDate = failed = 0;
+        texturesBaked = texturesUpToDate = texturesFailed = 0;
+    }
+};
+
+// Size and timestamp of a watched file, a change in either means a re-bake
+struct FileState {
+    uintmax_t size = 0;
+    fs::file_time_type mtime;
+    bool operator==(const FileState& other) const { return size == other.size && mtime == other.mtime; }
+    bool operator!=(const FileState& other) const { return !(*this == other); }
+};
+
+class Baker {
+public:
+    explicit Baker(const BakeOptions& options) : options(options), jobs(options.threads) {}
+
+    // Bakes every path on the job pool and blocks until all are done, stats
+    // then describe this pass
+    void bakeModels(const std::vector<std::string>& paths);
+    // Models whose materials resolved to this image file
+    std::vector<std::string> modelsUsing(const std::string& texture);
+
+    BakeStats stats;
+
+private:
+    const BakeOptions& options;
+    ThreadPool jobs;
+    ThreadPool filter;  // Mip filtering and BC encoding; job threads wait on it
+    std::mutex texturesMutex;
+    std::set<std::string> texturesClaimed;  // Baked (or being baked) this pass
+    std::map<std::string, std::set<std::string>> modelsByTexture;
+
+    void bakeModel(const std::string& path);
+};
+
+void Baker::bakeModels(const std::vector<std::string>& paths) {
+    stats.reset();
+    {
+        std::lock_guard<std::mutex> lock(texturesMutex);
+        texturesClaimed.clear();
+    }
+    for (const auto& path : paths) {
+        jobs.submit([this, path] { bakeModel(path); });
+    }
+    jobs.wait();
+}
+
+std::vector<std::string> Baker::modelsUsing(const std::string& texture) {
+    std::lock_guard<std::mutex> lock(texturesMutex);
+    auto it = modelsByTexture.find(texture);
+    return it == modelsByTexture.end() ? std::vector<std::string>()
+                                       : std::vector<std::string>(it->second.begin(), it->second.end());
+}
+
+void Baker::bakeModel(const std::string& path) {
+    ModelLoadOptions load = options.load;
+    // Models are the unit of parallelism here, and a cache hit only maps the entry
+    load.parallelConversion = false;
+    load.deferUpload = true;
+    load.outOfCore = true;
+    load.progress = nullptr;
+
+    if (options.force) {
+        MeshCacheKey key;
+        if (Model::makeCacheKey(path, load, key)) {
+            std::error_code ec;
+            fs::remove(MeshCache(load.meshCacheDirectory).entryPath(key), ec);
+        }
+    }
+
+    Model model(path.c_str(), load);
+    if (!model.isValid()) {
+        LOG_ERROR("ERROR::BAKE: Failed to bake " << path);
+        stats.failed++;
+        return;
+    }
+    (model.isFromCache() ? stats.upToDate : stats.imported)++;
+    if (!options.textures) {
+        return;
+    }
+
+    const TextureStreamSettings settings = model.getTextureSettings();
+    for (const auto& file : model.getTextureFiles()) {
+        const std::string texture = fs::weakly_canonical(file).string();
+        {
+            // Models sharing an image must not write its cache file concurrently
+            std::lock_guard<std::mutex> lock(texturesMutex);
+            modelsByTexture[texture].insert(path);
+            if (!texturesClaimed.insert(texture).second) {
+                continue;
+            }
+        }
+        bool skipped = false;
+        if (!TextureStreamer::bake(file, settings, options.force, &filter, &skipped)) {
+            stats.texturesFailed++;
+        } else {
+            (skipped ? stats.texturesUpToDate : stats.texturesBaked)++;
+        }
+    }
+}
+
+bool isImage(const fs::path& path) {
+    static const char* extensions[] = { ".png", ".jpg", ".jpeg", ".tga", ".bmp", ".psd", ".gif", ".hdr", ".pic", ".pnm" };
+    std::string extension = path.extension().string();
+    std::transform(extension.begin(), extension.end(), extension.begin(), ::tolower);
+    for (const char* candidate : extensions) {
+        if (extension == candidate) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// Every model and image under root, skipping the caches the bake itself writes
+void scan(const BakeOptions& options, const Assimp::Importer& importer,
+          std::map<std::string, FileState>& models, std::map<std::string, FileState>& images) {
+    models.clear();
+    images.clear();
+    std::error_code ec;
+    fs::recursive_directory_iterator it(options.root, fs::directory_options::skip_permission_denied, ec);
+    for (; !ec && it != fs::recursive_directory_iterator(); it.increment(ec)) {
+        const fs::path& path = it->path();
+        std::error_code fileError;  // Files vanishing mid-scan are simply skipped
+        if (it->is_directory(fileError)) {
+            const std::string name = path.filename().string();
+            if (name == "texture_cache" || fs::equivalent(path, options.load.meshCacheDirectory, fileError)) {
+                it.disable_recursion_pending();
+            }
+            continue;
+        }
+        if (!it->is_regular_file(fileError)) {
+            continue;
+        }
+        FileState state;
+        state.size = it->file_size(fileError);
+        state.mtime = it->last_write_time(fileError);
+        if (fileError) {
+            continue;
+        }
+        const std::string extension = path.extension().string();
+        if (isImage(path)) {
+            images[fs::weakly_canonical(path, fileError).string()] = state;
+        } else if (!extension.empty() && importer.IsExtensionSupported(extension)) {
+            models[path.string()] = state;
+        }
+    }
+}
+
+void printStats(const BakeStats& stats, double seconds) {
+    flushLog();  // Keep the summary below the per-model lines
+    std::cout << "Bake: " << stats.imported << " imported, " << stats.upToDate << " up to date, "
+              << stats.failed << " failed; textures " << stats.texturesBaked << " baked, "
+              << stats.texturesUpToDate << " up to date, " << stats.texturesFailed << " failed ("
+              << seconds << " s)" << std::endl;
+}
+
+// Polls the tree and re-bakes files once they have stopped changing for one
+// interval, so half-copied files are never imported
+void watch(const BakeOptions& options, Baker& baker, const Assimp::Importer& importer,
+           std::map<std::string, FileState> models, std::map<std::string, FileState> images) {
+    std::cout << "Watching " << options.root << " every " << options.intervalSeconds << " s, Ctrl+C to stop" << std::endl;
+    std::map<std::string, FileState> pending;
+    for (;;) {
+        std::this_thread::sleep_for(std::chrono::seconds(options.intervalSeconds));
+        std::map<std::string, FileState> currentModels, currentImages;
+        scan(options, importer, currentModels, currentImages);
+
+        std::set<std::string> changed;
+        auto collect = [&](const std::map<std::string, FileState>& current, std::map<std::string, FileState>& known,
+                           bool isModel) {
+            for (const auto& file : current) {
+                auto it = known.find(file.first);
+                if (it != known.end() && it->second == file.second) {
+                    pending.erase(file.first);
+                    continue;
+                }
+                auto waiting = pending.find(file.first);
+                if (waiting == pending.end() || waiting->second != file.second) {
+                    pending[file.first] = file.second;  // Still landing, look again next poll
+                    continue;
+                }
+                pending.erase(waiting);
+                known[file.first] = file.second;
+                if (isModel) {
+                    changed.insert(file.first);
+                } else {
+                    for (const auto& model : baker.modelsUsing(file.first)) {
+                        changed.insert(model);
+                    }
+                }
+            }
+        };
+        collect(currentModels, models, true);
+        collect(currentImages, images, false);
+        if (changed.empty()) {
+            continue;
+        }
+
+        std::cout << "Re-baking " << changed.size() << " changed model(s)" << std::endl;
+        auto start = std::chrono::steady_clock::now();
+        baker.bakeModels(std::vector<std::string>(changed.begin(), changed.end()));
+        printStats(baker.stats, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+}
+
+// Import stage totals of one profile over the whole corpus
+struct ProfileTimings {
+    ImportProfile profile;
+    size_t loaded = 0;
+    size_t failed = 0;
+    double readMs = 0.0;
+    double postProcessMs = 0.0;
+    double convertMs = 0.0;
+    double totalMs = 0.0;
+    uint64_t vertices = 0;
+    uint64_t triangles = 0;
+};
+
+double stageMilliseconds(const std::vector<LoadStage>& stages, const char* name, uint64_t* items = nullptr) {
+    for (const auto& stage : stages) {
+        if (stage.name == name) {
+            if (items) {
+                *items += stage.items;
+            }
+            return stage.milliseconds;
+        }
+    }
+    return 0.0;
+}
+
+// Imports every model fresh under each profile, one at a time so the timings
+// don't compete for cores, and prints the stage totals side by side
+void compareProfiles(const BakeOptions& options, const std::vector<std::string>& paths) {
+    std::vector<ProfileTimings> results;
+    for (ImportProfile profile : { ImportProfile::FastPreview, ImportProfile::Balanced, ImportProfile::FullValidation }) {
+        ProfileTimings timings;
+        timings.profile = profile;
+        for (const auto& path : paths) {
+            ModelLoadOptions load = options.load;
+            load.importProfile = profile;
+            load.useMeshCache = false;
+            load.deferUpload = true;
+            load.outOfCore = false;
+            load.reportDirectory.clear();
+            load.progress = nullptr;
+
+            Model model(path.c_str(), load);
+            if (!model.isValid()) {
+                timings.failed++;
+                continue;
+            }
+            timings.loaded++;
+            const std::vector<LoadStage> stages = model.getLoadReport().getStages();
+            timings.readMs += stageMilliseconds(stages, "Read file");
+            timings.postProcessMs += stageMilliseconds(stages, "Post-process");
+            timings.convertMs += stageMilliseconds(stages, "Convert meshes");
+            stageMilliseconds(stages, "Vertex conversion", &timings.vertices);
+            timings.totalMs += model.getLoadReport().getElapsedMilliseconds();
+            timings.triangles += model.getTriangleCount();
+        }
+        results.push_back(timings);
+    }
+
+    const double baseline = results.back().totalMs;
+    flushLog();
+    std::ios format(nullptr);
+    format.copyfmt(std::cout);
+    std::cout << "\nImport profiles over " << paths.size() << " models (fresh imports, milliseconds):\n"
+              << std::left << std::setw(18) << "Profile" << std::right << std::setw(8) << "Loaded"
+              << std::setw(8) << "Failed" << std::setw(10) << "Read" << std::setw(14) << "Post-process"
+              << std::setw(10) << "Convert" << std::setw(10) << "Total" << std::setw(12) << "Vertices"
+              << std::setw(12) << "Triangles" << std::setw(10) << "Speedup" << std::endl;
+    std::cout << std::fixed << std::setprecision(1);
+    for (const auto& timings : results) {
+        std::cout << std::left << std::setw(18) << importProfileName(timings.profile) << std::right
+                  << std::setw(8) << timings.loaded << std::setw(8) << timings.failed
+                  << std::setw(10) << timings.readMs << std::setw(14) << timings.postProcessMs
+                  << std::setw(10) << timings.convertMs << std::setw(10) << timings.totalMs
+                  << std::setw(12) << timings.vertices << std::setw(12) << timings.triangles
+                  << std::setw(9) << (timings.totalMs > 0.0 ? baseline / timings.totalMs : 0.0) << "x" << std::endl;
+    }
+    std::cout.copyfmt(format);
+}
+
+bool parseProfile(const std::string& name, ImportProfile& profile) {
+    if (name == "fast") {
+        profile = ImportProfile::FastPreview;
+    } else if (name == "balanced") {
+        profile = ImportProfile::Balanced;
+    } else if (name == "full") {
+        profile = ImportProfile::FullValidation;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+void printUsage() {
+    std::cout << "Usage: bake <directory> [options]\n"
+              << "  --watch               Keep running and re-bake files as they change\n"
+              << "  --interval <seconds>  Watch poll interval (default 2)\n"
+              << "  --threads <n>         Models baked in parallel (default: all cores)\n"
+              << "  --force               Rebuild entries that are already up to date\n"
+              << "  --cache <directory>   Mesh cache location (default: cache)\n"
+              << "  --no-textures         Only bake geometry\n"
+              << "  --profile <name>      Import profile: fast, balanced or full (default full)\n"
+              << "  --instancing          Keep the node hierarchy and instance repeated meshes\n"
+              << "  --compare-profiles    Time fresh imports under every profile instead of baking\n"
+              << "  --compress            Bake block-compressed textures\n"
+              << "  --high-quality        Use the high quality compression preset\n"
+              << "  --no-optimize         Skip vertex cache / overdraw / fetch optimization\n"
+              << "  --lods <n>            Levels of detail per mesh (default 4)\n"
+              << "  --no-meshlets         Skip meshlet generation\n"
+              << "  --log-level <level>   debug, info, warning, error or off (default info)\n";
+}
+
+bool parseArguments(int argc, char** argv, BakeOptions& options) {
+    LogLevel level;
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        const bool hasValue = i + 1 < argc;
+        if (arg == "--watch") {
+            options.watch = true;
+        } else if (arg == "--interval" && hasValue) {
+            options.intervalSeconds = std::max(1, std::atoi(argv[++i]));
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = static_cast<unsigned int>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--force") {
+            options.force = true;
+        } else if (arg == "--cache" && hasValue) {
+            options.load.meshCacheDirectory = argv[++i];
+        } else if (arg == "--no-textures") {
+            options.textures = false;
+        } else if (arg == "--profile" && hasValue && parseProfile(argv[i + 1], options.load.importProfile)) {
+            i++;
+        } else if (arg == "--instancing") {
+            options.load.instancing = true;
+        } else if (arg == "--compare-profiles") {
+            options.compareProfiles = true;
+        } else if (arg == "--compress") {
+            options.load.compressTextures = true;
+        } else if (arg == "--high-quality") {
+            options.load.compressionQuality = CompressionQuality::High;
+        } else if (arg == "--no-optimize") {
+            options.load.optimizeMeshes = false;
+        } else if (arg == "--lods" && hasValue) {
+            options.load.lodLevels = static_cast<unsigned int>(std::max(0, std::atoi(argv[++i])));
+        } else if (arg == "--no-meshlets") {
+            options.load.buildMeshlets = false;
+        } else if (arg == "--log-level" && hasValue && parseLogLevel(argv[i + 1], level)) {
+            setLogLevel(level);
+            i++;
+        } else if (!arg.empty() && arg[0] != '-' && options.root.empty()) {
+            options.root = arg;
+        } else {
+            std::cerr << "ERROR::BAKE: Unknown or incomplete argument " << arg << std::endl;
+            return false;
+        }
+    }
+    return !options.root.empty();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    BakeOptions options;
+    if (!parseArguments(argc, argv, options)) {
+        printUsage();
+        return 2;
+    }
+    std::error_code ec;
+    if (!fs::is_directory(options.root, ec)) {
+        std::cerr << "ERROR::BAKE: Not a directory: " << options.root << std::endl;
+        return 2;
+    }
+
+    Assimp::Importer importer;  // Only asked which extensions it supports
+    std::map<std::string, FileState> models, images;
+    scan(options, importer, models, images);
+    std::cout << "Found " << models.size() << " models under " << options.root << std::endl;
+
+    std::vector<std::string> paths;
+    for (const auto& model : models) {
+        paths.push_back(model.first);
+    }
+    if (options.compareProfiles) {
+        compareProfiles(options, paths);
+        return 0;
+    }
+
+    Baker baker(options);
+    auto start = std::chrono::steady_clock::now();
+    baker.bakeModels(paths);
+    printStats(baker.stats, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+
+    if (options.watch) {
+        options.force = false;  // Changed files miss the cache on their own
+        watch(options, baker, importer, std::move(models), std::move(images));
+    }
+    return baker.stats.failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,163 @@
+#include "bounds_cull.h"
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PGV_HAVE_SSE2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define PGV_TARGET_AVX
+#else
+#define PGV_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+void BoundsArrays::resize(size_t newCount) {
+    count = newCount;
+    const size_t padded = (newCount + LANES - 1) / LANES * LANES;
+    for (std::vector<float>* array : { &centerX, &centerY, &centerZ, &extentX, &extentY, &extentZ, &radius }) {
+        array->resize(padded, 0.0f);
+    }
+}
+
+void BoundsArrays::set(size_t i, const glm::vec3& center, const glm::vec3& extent) {
+    centerX[i] = center.x;
+    centerY[i] = center.y;
+    centerZ[i] = center.z;
+    extentX[i] = extent.x;
+    extentY[i] = extent.y;
+    extentZ[i] = extent.z;
+    radius[i] = glm::length(extent);
+}
+
+namespace {
+
+// A box is outside when its center is further behind one plane than the box
+// reaches along that plane's normal, and the sphere is inside when it is in
+// front of every plane by at least its radius
+void cullScalar(const Frustum& frustum, const BoundsArrays& bounds, uint8_t* results) {
+    for (size_t i = 0; i < bounds.paddedSize(); i++) {
+        bool outside = false;
+        bool inside = true;
+        for (const glm::vec4& plane : frustum.planes) {
+            const float distance = plane.x * bounds.centerX[i] + plane.y * bounds.centerY[i] +
+                                   plane.z * bounds.centerZ[i] + plane.w;
+            const float reach = std::fabs(plane.x) * bounds.extentX[i] + std::fabs(plane.y) * bounds.extentY[i] +
+                                std::fabs(plane.z) * bounds.extentZ[i];
+            outside |= distance + reach < 0.0f;
+            inside &= distance >= bounds.radius[i];
+        }
+        results[i] = outside ? CULL_OUTSIDE : (inside ? CULL_INSIDE : CULL_INTERSECTING);
+    }
+}
+
+#ifdef PGV_HAVE_SSE2
+
+inline void storeResults(int outsideMask, int insideMask, int lanes, uint8_t* results) {
+    for (int lane = 0; lane < lanes; lane++) {
+        results[lane] = (outsideMask >> lane) & 1 ? CULL_OUTSIDE
+                        : ((insideMask >> lane) & 1 ? CULL_INSIDE : CULL_INTERSECTING);
+    }
+}
+
+// Four boxes per register against one broadcast plane at a time
+void cullSSE2(const Frustum& frustum, const BoundsArrays& bounds, uint8_t* results) {
+    for (size_t i = 0; i < bounds.paddedSize(); i += 4) {
+        const __m128 cx = _mm_loadu_ps(&bounds.centerX[i]);
+        const __m128 cy = _mm_loadu_ps(&bounds.centerY[i]);
+        const __m128 cz = _mm_loadu_ps(&bounds.centerZ[i]);
+        const __m128 ex = _mm_loadu_ps(&bounds.extentX[i]);
+        const __m128 ey = _mm_loadu_ps(&bounds.extentY[i]);
+        const __m128 ez = _mm_loadu_ps(&bounds.extentZ[i]);
+        const __m128 r = _mm_loadu_ps(&bounds.radius[i]);
+        __m128 outside = _mm_setzero_ps();
+        __m128 inside = _mm_cmpeq_ps(r, r);
+        for (const glm::vec4& plane : frustum.planes) {
+            __m128 distance = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.x), cx), _mm_mul_ps(_mm_set1_ps(plane.y), cy));
+            distance = _mm_add_ps(distance, _mm_add_ps(_mm_mul_ps(_mm_set1_ps(plane.z), cz), _mm_set1_ps(plane.w)));
+            __m128 reach = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(std::fabs(plane.x)), ex),
+                                      _mm_mul_ps(_mm_set1_ps(std::fabs(plane.y)), ey));
+            reach = _mm_add_ps(reach, _mm_mul_ps(_mm_set1_ps(std::fabs(plane.z)), ez));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, reach), _mm_setzero_ps()));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(distance, r));
+        }
+        storeResults(_mm_movemask_ps(outside), _mm_movemask_ps(inside), 4, results + i);
+    }
+}
+
+// Same tests, eight boxes per register
+PGV_TARGET_AVX
+void cullAVX(const Frustum& frustum, const BoundsArrays& bounds, uint8_t* results) {
+    for (size_t i = 0; i < bounds.paddedSize(); i += 8) {
+        const __m256 cx = _mm256_loadu_ps(&bounds.centerX[i]);
+        const __m256 cy = _mm256_loadu_ps(&bounds.centerY[i]);
+        const __m256 cz = _mm256_loadu_ps(&bounds.centerZ[i]);
+        const __m256 ex = _mm256_loadu_ps(&bounds.extentX[i]);
+        const __m256 ey = _mm256_loadu_ps(&bounds.extentY[i]);
+        const __m256 ez = _mm256_loadu_ps(&bounds.extentZ[i]);
+        const __m256 r = _mm256_loadu_ps(&bounds.radius[i]);
+        __m256 outside = _mm256_setzero_ps();
+        __m256 inside = _mm256_cmp_ps(r, r, _CMP_EQ_OQ);
+        for (const glm::vec4& plane : frustum.planes) {
+            __m256 distance = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.x), cx),
+                                            _mm256_mul_ps(_mm256_set1_ps(plane.y), cy));
+            distance = _mm256_add_ps(distance, _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(plane.z), cz),
+                                                             _mm256_set1_ps(plane.w)));
+            __m256 reach = _mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.x)), ex),
+                                         _mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.y)), ey));
+            reach = _mm256_add_ps(reach, _mm256_mul_ps(_mm256_set1_ps(std::fabs(plane.z)), ez));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(_mm256_add_ps(distance, reach), _mm256_setzero_ps(), _CMP_LT_OQ));
+            inside = _mm256_and_ps(inside, _mm256_cmp_ps(distance, r, _CMP_GE_OQ));
+        }
+        storeResults(_mm256_movemask_ps(outside), _mm256_movemask_ps(inside), 8, results + i);
+    }
+    _mm256_zeroupper();
+}
+
+bool cpuSupportsAVX() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    // The OS must also save the YMM registers on context switches
+    return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#else
+    return __builtin_cpu_supports("avx");
+#endif
+}
+
+#endif // PGV_HAVE_SSE2
+
+} // namespace
+
+CullPath bestCullPath() {
+#ifdef PGV_HAVE_SSE2
+    static const CullPath best = cpuSupportsAVX() ? CullPath::AVX : CullPath::SSE2;
+    return best;
+#else
+    return CullPath::Scalar;
+#endif
+}
+
+const char* cullPathName(CullPath path) {
+    switch (path) {
+        case CullPath::SSE2: return "SSE2";
+        case CullPath::AVX: return "AVX";
+        default: return "scalar";
+    }
+}
+
+void cullBounds(const Frustum& frustum, const BoundsArrays& bounds, uint8_t* results, CullPath path) {
+#ifdef PGV_HAVE_SSE2
+    if (path == CullPath::AVX) {
+        cullAVX(frustum, bounds, results);
+        return;
+    }
+    if (path == CullPath::SSE2) {
+        cullSSE2(frustum, bounds, results);
+        return;
+    }
+#endif
+    cullScalar(frustum, bounds, results);
+}
@@ -0,0 +1,120 @@
+#include "file_watcher.h"
+#include "hash.h"
+#include <algorithm>
+#include <filesystem>
+#include <set>
+
+namespace fs = std::filesystem;
+
+FileWatcher::FileWatcher(std::chrono::milliseconds interval) : interval(interval) {
+    worker = std::thread([this] { run(); });
+}
+
+FileWatcher::~FileWatcher() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    worker.join();
+}
+
+void FileWatcher::watch(const std::vector<std::string>& watched) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        files = watched;
+        generation++;
+        // Changes to files that stay watched are still news
+        changed.erase(std::remove_if(changed.begin(), changed.end(), [&](const std::string& file) {
+            return std::find(watched.begin(), watched.end(), file) == watched.end();
+        }), changed.end());
+    }
+    wake.notify_all();
+}
+
+std::vector<std::string> FileWatcher::takeChanged() {
+    std::lock_guard<std::mutex> lock(mutex);
+    std::vector<std::string> result;
+    result.swap(changed);
+    return result;
+}
+
+bool FileWatcher::stat(const std::string& file, FileState& state) {
+    std::error_code ec;
+    state.size = fs::file_size(file, ec);
+    if (ec) {
+        return false;
+    }
+    state.mtime = static_cast<int64_t>(fs::last_write_time(file, ec).time_since_epoch().count());
+    return !ec;
+}
+
+void FileWatcher::run() {
+    std::map<std::string, FileState> known;    // Last reported contents
+    std::map<std::string, FileState> pending;  // Changed, waiting to hold still
+    std::vector<std::string> snapshot;
+    size_t seenGeneration = 0;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            // A new watch set is picked up right away, otherwise poll once per interval
+            wake.wait_for(lock, interval, [&] { return stopping || generation != seenGeneration; });
+            if (stopping) {
+                return;
+            }
+            if (generation != seenGeneration) {
+                seenGeneration = generation;
+                snapshot = files;
+                // Files that stay watched keep their state, so re-watching after a reload
+                // reads nothing and edits made meanwhile are not taken as the baseline
+                const std::set<std::string> watched(snapshot.begin(), snapshot.end());
+                for (auto* states : { &known, &pending }) {
+                    for (auto it = states->begin(); it != states->end();) {
+                        it = watched.count(it->first) ? std::next(it) : states->erase(it);
+                    }
+                }
+            }
+        }
+
+        std::vector<std::string> found;
+        for (const auto& file : snapshot) {
+            FileState state;
+            if (!stat(file, state)) {
+                continue;  // Missing while an exporter replaces it, look again next poll
+            }
+            auto it = known.find(file);
+            if (it == known.end()) {
+                // The baseline is the stat alone, contents are only read once it changes
+                known[file] = state;
+                continue;
+            }
+            if (it->second == state) {
+                pending.erase(file);
+                continue;
+            }
+            auto waiting = pending.find(file);
+            if (waiting == pending.end() || waiting->second != state) {
+                pending[file] = state;
+                continue;
+            }
+            pending.erase(waiting);
+            // An unreadable file is reported, the reload says why it failed
+            state.hashed = hashFile(file, state.hash);
+            if (!state.hashed || !it->second.hashed || state.hash != it->second.hash) {
+                found.push_back(file);
+            }
+            it->second = state;
+        }
+
+        if (!found.empty()) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (generation == seenGeneration) {
+                for (const auto& file : found) {
+                    if (std::find(changed.begin(), changed.end(), file) == changed.end()) {
+                        changed.push_back(file);
+                    }
+                }
+            }
+        }
+    }
+}
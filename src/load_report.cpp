@@ -0,0 +1,173 @@
+#include "load_report.h"
+#include "allocation_counter.h"
+#include "log.h"
+#include "memory_usage.h"
+#include <cstdio>
+#include <ctime>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+std::string jsonEscape(const std::string& text) {
+    std::string escaped;
+    for (char c : text) {
+        switch (c) {
+            case '"': escaped += "\\\""; break;
+            case '\\': escaped += "\\\\"; break;
+            case '\n': escaped += "\\n"; break;
+            case '\t': escaped += "\\t"; break;
+            default:
+                if (static_cast<unsigned char>(c) < 0x20) {
+                    char buffer[8];
+                    std::snprintf(buffer, sizeof(buffer), "\\u%04x", c);
+                    escaped += buffer;
+                } else {
+                    escaped += c;
+                }
+        }
+    }
+    return escaped;
+}
+
+} // namespace
+
+LoadReport::LoadReport() : start(std::chrono::steady_clock::now()) {
+}
+
+void LoadReport::record(const std::string& name, double milliseconds, uint64_t bytes, uint64_t items,
+                        const char* itemName, uint64_t allocations) {
+    std::lock_guard<std::mutex> lock(mutex);
+    LoadStage* stage = nullptr;
+    for (auto& existing : stages) {
+        if (existing.name == name) {
+            stage = &existing;
+            break;
+        }
+    }
+    if (!stage) {
+        stages.emplace_back();
+        stage = &stages.back();
+        stage->name = name;
+    }
+    stage->milliseconds += milliseconds;
+    stage->bytes += bytes;
+    stage->items += items;
+    stage->allocations += allocations;
+    if (stage->itemName.empty() && itemName) {
+        stage->itemName = itemName;
+    }
+    stage->calls++;
+}
+
+std::vector<LoadStage> LoadReport::getStages() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stages;
+}
+
+double LoadReport::getElapsedMilliseconds() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (finished) {
+        return elapsed;
+    }
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void LoadReport::finish() {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!finished) {
+        elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        finished = true;
+    }
+}
+
+bool LoadReport::isFinished() const {
+    std::lock_guard<std::mutex> lock(mutex);
+    return finished;
+}
+
+void LoadReport::print(std::ostream& out) const {
+    // Leave the caller's stream formatting as it was
+    std::ios format(nullptr);
+    format.copyfmt(out);
+    out << "Load report (" << getElapsedMilliseconds() << " ms total):\n";
+    for (const auto& stage : getStages()) {
+        out << "  " << std::left << std::setw(20) << stage.name << std::right << std::fixed << std::setprecision(1)
+            << std::setw(10) << stage.milliseconds << " ms";
+        if (stage.bytes > 0) {
+            out << std::setw(10) << stage.megabytesPerSecond() << " MB/s";
+        }
+        if (stage.items > 0) {
+            out << "  " << stage.items << " " << stage.itemName << " (" << stage.itemsPerSecond() << "/s)";
+        }
+        if (allocationCountingEnabled()) {
+            out << "  " << stage.allocations << " allocations";
+        }
+        out << '\n';
+    }
+    out.copyfmt(format);
+}
+
+std::string LoadReport::toJson(const std::string& modelPath, bool fromCache) const {
+    std::ostringstream json;
+    json << "{\n";
+    json << "  \"model\": \"" << jsonEscape(modelPath) << "\",\n";
+    json << "  \"build\": \"" << __DATE__ << " " << __TIME__ << "\",\n";
+    json << "  \"fromCache\": " << (fromCache ? "true" : "false") << ",\n";
+    json << "  \"allocationsCounted\": " << (allocationCountingEnabled() ? "true" : "false") << ",\n";
+    json << "  \"totalMilliseconds\": " << getElapsedMilliseconds() << ",\n";
+    json << "  \"residentBytes\": " << getResidentBytes() << ",\n";
+    json << "  \"peakResidentBytes\": " << getPeakResidentBytes() << ",\n";
+    json << "  \"stages\": [";
+    const std::vector<LoadStage> snapshot = getStages();
+    for (size_t i = 0; i < snapshot.size(); i++) {
+        const LoadStage& stage = snapshot[i];
+        json << (i > 0 ? "," : "") << "\n    {"
+             << "\"name\": \"" << jsonEscape(stage.name) << "\", "
+             << "\"milliseconds\": " << stage.milliseconds << ", "
+             << "\"calls\": " << stage.calls << ", "
+             << "\"bytes\": " << stage.bytes << ", "
+             << "\"megabytesPerSecond\": " << stage.megabytesPerSecond() << ", "
+             << "\"items\": " << stage.items << ", "
+             << "\"itemName\": \"" << jsonEscape(stage.itemName) << "\", "
+             << "\"itemsPerSecond\": " << stage.itemsPerSecond() << ", "
+             << "\"allocations\": " << stage.allocations << "}";
+    }
+    json << "\n  ]\n}\n";
+    return json.str();
+}
+
+std::string LoadReport::write(const std::string& directory, const std::string& modelPath, bool fromCache) const {
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+
+    std::time_t now = std::time(nullptr);
+    char timestamp[32];
+    std::strftime(timestamp, sizeof(timestamp), "%Y%m%d-%H%M%S", std::localtime(&now));
+    const std::string path = (fs::path(directory) /
+                              (fs::path(modelPath).stem().string() + "-" + timestamp + ".json")).string();
+
+    std::ofstream out(path, std::ios::trunc);
+    if (!out) {
+        LOG_ERROR("ERROR::LOAD_REPORT::WRITE: Cannot open " << path << " for writing");
+        return std::string();
+    }
+    out << toJson(modelPath, fromCache);
+    return out ? path : std::string();
+}
+
+ScopedTimer::ScopedTimer(LoadReport* report, const char* stage, const char* itemName)
+    : report(report), stage(stage), itemName(itemName), start(std::chrono::steady_clock::now()),
+      startAllocations(getThreadAllocationCount()) {
+}
+
+ScopedTimer::~ScopedTimer() {
+    if (report) {
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        report->record(stage, elapsed.count(), bytes, items, itemName, getThreadAllocationCount() - startAllocations);
+    }
+}
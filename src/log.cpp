@@ -0,0 +1,242 @@
+#include "log.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+std::atomic<int> logMinimumLevel{static_cast<int>(LogLevel::Info)};
+
+namespace {
+
+// Appends everything streamed into it to a string that keeps its capacity,
+// so formatting a line does not allocate once the buffer has grown
+class StringAppendBuffer : public std::streambuf {
+public:
+    std::string text;
+
+protected:
+    int_type overflow(int_type c) override {
+        if (c != traits_type::eof()) {
+            text.push_back(static_cast<char>(c));
+        }
+        return c;
+    }
+    std::streamsize xsputn(const char* s, std::streamsize count) override {
+        text.append(s, static_cast<size_t>(count));
+        return count;
+    }
+};
+
+struct ThreadStream {
+    StringAppendBuffer buffer;
+    std::ostream stream{&buffer};
+};
+
+ThreadStream& threadStream() {
+    thread_local ThreadStream local;
+    return local;
+}
+
+// Bounded multi-producer, single-consumer ring (Vyukov's sequence-numbered
+// slots). Producers claim a slot with one CAS; the sink thread is the only reader.
+class Logger {
+public:
+    Logger() : slots(new Slot[CAPACITY]) {
+        for (size_t i = 0; i < CAPACITY; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        sink = std::thread([this] { run(); });
+    }
+
+    ~Logger() {
+        stopping = true;
+        wake.notify_one();
+        sink.join();
+    }
+
+    void push(LogLevel level, const std::string& text) {
+        size_t position = tail.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots[position & (CAPACITY - 1)];
+            const size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            const intptr_t difference = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(position);
+            if (difference == 0) {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (difference < 0) {
+                // Full: chatter is dropped, warnings and errors wait for the sink
+                if (level < LogLevel::Warning) {
+                    dropped.fetch_add(1, std::memory_order_relaxed);
+                    return;
+                }
+                std::this_thread::yield();
+                position = tail.load(std::memory_order_relaxed);
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->level = level;
+        slot->length = text.size();
+        if (text.size() <= INLINE_BYTES) {
+            std::memcpy(slot->inlineText, text.data(), text.size());
+        } else {
+            slot->longText.assign(text);  // Reuses the slot's capacity from earlier long lines
+        }
+        slot->sequence.store(position + 1, std::memory_order_release);
+        // Wake the sink early during bursts instead of letting the ring fill up
+        if ((position & (WAKE_INTERVAL - 1)) == WAKE_INTERVAL - 1) {
+            wake.notify_one();
+        }
+    }
+
+    void flush() {
+        const size_t target = tail.load(std::memory_order_acquire);
+        // Dropped lines never claim a slot, so only written lines count towards the tail.
+        // The sink flushes the streams before it publishes the count.
+        while (written.load(std::memory_order_acquire) < target) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+
+    LogStats stats() const {
+        LogStats result;
+        result.written = written.load(std::memory_order_relaxed);
+        result.dropped = dropped.load(std::memory_order_relaxed);
+        result.sinkMilliseconds = sinkNanoseconds.load(std::memory_order_relaxed) / 1e6;
+        return result;
+    }
+
+private:
+    static constexpr size_t CAPACITY = 8192;  // Power of two
+    static constexpr size_t WAKE_INTERVAL = CAPACITY / 4;
+    static constexpr size_t INLINE_BYTES = 232;
+
+    struct Slot {
+        std::atomic<size_t> sequence{0};
+        LogLevel level = LogLevel::Info;
+        size_t length = 0;
+        char inlineText[INLINE_BYTES];
+        std::string longText;
+    };
+
+    std::unique_ptr<Slot[]> slots;
+    alignas(64) std::atomic<size_t> tail{0};
+    alignas(64) size_t head = 0;  // Sink thread only
+    std::atomic<uint64_t> written{0};
+    std::atomic<uint64_t> dropped{0};
+    std::atomic<uint64_t> sinkNanoseconds{0};
+    std::atomic<bool> stopping{false};
+    std::mutex sleepMutex;  // Only guards the sink's idle wait, never taken by producers
+    std::condition_variable wake;
+    std::thread sink;
+
+    // Drains everything queued, returns the number of lines written
+    size_t drain(std::string& out, std::string& errors) {
+        size_t count = 0;
+        for (;;) {
+            Slot& slot = slots[head & (CAPACITY - 1)];
+            if (slot.sequence.load(std::memory_order_acquire) != head + 1) {
+                break;
+            }
+            std::string& target = slot.level >= LogLevel::Warning ? errors : out;
+            if (slot.length <= INLINE_BYTES) {
+                target.append(slot.inlineText, slot.length);
+            } else {
+                target.append(slot.longText);
+            }
+            target.push_back('\n');
+            slot.sequence.store(head + CAPACITY, std::memory_order_release);
+            head++;
+            count++;
+        }
+        return count;
+    }
+
+    void run() {
+        std::string out, errors;
+        for (;;) {
+            const bool last = stopping.load();
+            auto start = std::chrono::steady_clock::now();
+            const size_t count = drain(out, errors);
+            if (count > 0) {
+                // One write and one flush per batch instead of per line
+                std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+                std::cout.flush();
+                std::cerr.write(errors.data(), static_cast<std::streamsize>(errors.size()));
+                std::cerr.flush();
+                out.clear();
+                errors.clear();
+                std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+                sinkNanoseconds.fetch_add(static_cast<uint64_t>(elapsed.count()), std::memory_order_relaxed);
+                written.fetch_add(count, std::memory_order_release);
+            } else if (last) {
+                return;  // Drained after the stop request, nothing can be lost
+            } else {
+                std::unique_lock<std::mutex> lock(sleepMutex);
+                wake.wait_for(lock, std::chrono::milliseconds(1));
+            }
+        }
+    }
+};
+
+Logger& logger() {
+    static Logger instance;
+    return instance;
+}
+
+} // namespace
+
+void setLogLevel(LogLevel level) {
+    logMinimumLevel.store(static_cast<int>(level), std::memory_order_relaxed);
+}
+
+LogLevel getLogLevel() {
+    return static_cast<LogLevel>(logMinimumLevel.load(std::memory_order_relaxed));
+}
+
+const char* logLevelName(LogLevel level) {
+    switch (level) {
+        case LogLevel::Debug: return "debug";
+        case LogLevel::Info: return "info";
+        case LogLevel::Warning: return "warning";
+        case LogLevel::Error: return "error";
+        default: return "off";
+    }
+}
+
+bool parseLogLevel(const std::string& name, LogLevel& level) {
+    for (LogLevel candidate : { LogLevel::Debug, LogLevel::Info, LogLevel::Warning, LogLevel::Error, LogLevel::Off }) {
+        if (name == logLevelName(candidate)) {
+            level = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+void flushLog() {
+    logger().flush();
+}
+
+LogStats getLogStats() {
+    return logger().stats();
+}
+
+std::ostream& logBegin() {
+    ThreadStream& local = threadStream();
+    local.buffer.text.clear();
+    // Undo manipulators a previous line left behind
+    local.stream.flags(std::ios_base::dec | std::ios_base::skipws);
+    local.stream.precision(6);
+    local.stream.width(0);
+    return local.stream;
+}
+
+void logCommit(LogLevel level) {
+    logger().push(level, threadStream().buffer.text);
+}
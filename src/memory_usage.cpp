@@ -0,0 +1,58 @@
+#include "memory_usage.h"
+
+#ifdef _WIN32
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <cstdio>
+#include <cstring>
+#endif
+
+namespace {
+
+#ifndef _WIN32
+// Reads a "Name:   1234 kB" line of /proc/self/status
+size_t readStatusKilobytes(const char* name) {
+    FILE* status = std::fopen("/proc/self/status", "r");
+    if (!status) {
+        return 0;
+    }
+    char line[256];
+    size_t kilobytes = 0;
+    const size_t nameLength = std::strlen(name);
+    while (std::fgets(line, sizeof(line), status)) {
+        if (std::strncmp(line, name, nameLength) == 0 && line[nameLength] == ':') {
+            std::sscanf(line + nameLength + 1, "%zu", &kilobytes);
+            break;
+        }
+    }
+    std::fclose(status);
+    return kilobytes;
+}
+#endif
+
+} // namespace
+
+size_t getResidentBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.WorkingSetSize;
+#else
+    return readStatusKilobytes("VmRSS") * 1024;
+#endif
+}
+
+size_t getPeakResidentBytes() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) {
+        return 0;
+    }
+    return counters.PeakWorkingSetSize;
+#else
+    return readStatusKilobytes("VmHWM") * 1024;
+#endif
+}
@@ -1,36 +1,283 @@
 #include "mesh.h"
+#include "meshlet.h"
+#include "vertex_quantize.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
 
-Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures)
-    : vertices(vertices), indices(indices), textures(textures) {
+Mesh::Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures,
+           const glm::vec3& localMin, const glm::vec3& localMax, VertexFormat format, std::vector<MeshLod> lods, std::vector<Meshlet> meshlets,
+           std::vector<glm::mat4> instances)
+    : vertices(std::move(vertices)), indices(std::move(indices)), textures(std::move(textures)),
+      instances(std::move(instances)), vertexFormat(format), lods(std::move(lods)), meshlets(std::move(meshlets)) {
+    setupBounds(localMin, localMax);
     setupMesh();
 }
 
+void Mesh::replace(std::vector<Vertex> newVertices, std::vector<unsigned int> newIndices,
+                   std::vector<Texture> newTextures, const glm::vec3& localMin, const glm::vec3& localMax,
+                   std::vector<MeshLod> newLods, std::vector<Meshlet> newMeshlets, std::vector<glm::mat4> newInstances) {
+    vertices = std::move(newVertices);
+    indices = std::move(newIndices);
+    textures = std::move(newTextures);
+    lods = std::move(newLods);
+    meshlets = std::move(newMeshlets);
+    instances = std::move(newInstances);
+    setupBounds(localMin, localMax);
+    // Same VAO and buffer names, glBufferData respecifies their storage
+    setupMesh();
+}
+
+void Mesh::setupBounds(const glm::vec3& localMin, const glm::vec3& localMax) {
+    if (lods.empty()) {
+        MeshLod full;
+        full.indexCount = static_cast<unsigned int>(indices.size());
+        lods.push_back(full);
+    }
+
+    // Found while the vertices were converted, the quantized layout reuses it
+    boundsMin = localMin;
+    boundsMax = localMax;
+    if (vertices.empty()) {
+        boundsMin = boundsMax = glm::vec3(0.0f);
+    }
+    boundsCenter = (boundsMin + boundsMax) * 0.5f;
+    boundsExtent = (boundsMax - boundsMin) * 0.5f;
+    boundsRadius = glm::length(boundsExtent);
+}
+
+Mesh::~Mesh() {
+    // Zero names are ignored, so moved-from meshes are fine
+    glDeleteVertexArrays(1, &VAO);
+    glDeleteBuffers(1, &VBO);
+    glDeleteBuffers(1, &EBO);
+    glDeleteBuffers(1, &instanceVBO);
+}
+
+Mesh::Mesh(Mesh&& other) noexcept {
+    *this = std::move(other);
+}
+
+Mesh& Mesh::operator=(Mesh&& other) noexcept {
+    if (this != &other) {
+        glDeleteVertexArrays(1, &VAO);
+        glDeleteBuffers(1, &VBO);
+        glDeleteBuffers(1, &EBO);
+        glDeleteBuffers(1, &instanceVBO);
+        vertices = std::move(other.vertices);
+        indices = std::move(other.indices);
+        textures = std::move(other.textures);
+        VAO = std::exchange(other.VAO, 0);
+        VBO = std::exchange(other.VBO, 0);
+        EBO = std::exchange(other.EBO, 0);
+        instanceVBO = std::exchange(other.instanceVBO, 0);
+        instances = std::move(other.instances);
+        instanceNodes = std::move(other.instanceNodes);
+        instanceVersion = other.instanceVersion;
+        inverseInstance = other.inverseInstance;
+        indexType = other.indexType;
+        vertexCount = other.vertexCount;
+        indexCount = other.indexCount;
+        vertexFormat = other.vertexFormat;
+        lods = std::move(other.lods);
+        meshlets = std::move(other.meshlets);
+        boundsCenter = other.boundsCenter;
+        boundsExtent = other.boundsExtent;
+        boundsMin = other.boundsMin;
+        boundsMax = other.boundsMax;
+        boundsRadius = other.boundsRadius;
+        positionOffset = other.positionOffset;
+        positionScale = other.positionScale;
+    }
+    return *this;
+}
+
+size_t Mesh::selectLod(const DrawView& view) const {
+    if (lods.size() <= 1) {
+        return 0;
+    }
+    // The smallest ratio of distance to radius needs the finest level
+    float radius = 0.0f;
+    float distance = std::numeric_limits<float>::max();
+    for (size_t i = 0; i < getInstanceCount(); i++) {
+        const glm::mat4 model = instances.empty() ? view.model : view.model * instances[i];
+        glm::vec3 center = glm::vec3(model * glm::vec4(boundsCenter, 1.0f));
+        float scale = std::max(glm::length(glm::vec3(model[0])),
+                               std::max(glm::length(glm::vec3(model[1])), glm::length(glm::vec3(model[2]))));
+        // Distance to the nearest point of the bounding sphere, full detail once inside it
+        float instanceRadius = boundsRadius * scale;
+        float instanceDistance = glm::length(center - view.cameraPosition) - instanceRadius;
+        if (instanceDistance <= 0.0f) {
+            return 0;
+        }
+        if (radius == 0.0f || instanceDistance * radius < distance * instanceRadius) {
+            radius = instanceRadius;
+            distance = instanceDistance;
+        }
+    }
+    if (radius == 0.0f) {
+        return 0;
+    }
+    for (size_t lod = lods.size() - 1; lod > 0; lod--) {
+        float pixels = lods[lod].error * radius / distance * view.pixelsPerUnit;
+        if (pixels <= view.maxPixelError) {
+            return lod;
+        }
+    }
+    return 0;
+}
+
+size_t Mesh::getVertexBytes() const {
+    return vertexCount * (vertexFormat == VertexFormat::Quantized ? sizeof(PackedVertex) : sizeof(Vertex));
+}
+
+void Mesh::releaseCpuData() {
+    std::vector<Vertex>().swap(vertices);
+    std::vector<unsigned int>().swap(indices);
+}
+
 void Mesh::setupMesh() {
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    glGenBuffers(1, &EBO);
+    if (VAO == 0) {
+        glGenVertexArrays(1, &VAO);
+        glGenBuffers(1, &VBO);
+        glGenBuffers(1, &EBO);
+    }
   
     glBindVertexArray(VAO);
     glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
+    if (vertexFormat == VertexFormat::Quantized) {
+        setupQuantizedAttributes();
+    } else {
+        glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);  
 
+        // vertex positions
+        glEnableVertexAttribArray(0);   
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        // vertex normals
+        glEnableVertexAttribArray(1);   
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+        // vertex texture coords
+        glEnableVertexAttribArray(2);   
+        glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+    }
+
+    // Meshes with at most 65536 vertices only need 16-bit indices on the GPU,
+    // narrowed straight into the mapped buffer instead of a staging copy
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
-
-    // vertex positions
-    glEnableVertexAttribArray(0);   
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    // vertex normals
-    glEnableVertexAttribArray(1);   
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
-    // vertex texture coords
-    glEnableVertexAttribArray(2);   
-    glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
+    if (vertices.size() <= 65536) {
+        indexType = GL_UNSIGNED_SHORT;
+        const size_t bytes = indices.size() * sizeof(unsigned short);
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, bytes, nullptr, GL_STATIC_DRAW);
+        void* mapped = bytes > 0 ? glMapBufferRange(GL_ELEMENT_ARRAY_BUFFER, 0, bytes,
+                                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT) : nullptr;
+        if (mapped) {
+            std::copy(indices.begin(), indices.end(), static_cast<unsigned short*>(mapped));
+            glUnmapBuffer(GL_ELEMENT_ARRAY_BUFFER);
+        } else if (bytes > 0) {
+            std::vector<unsigned short> shortIndices(indices.begin(), indices.end());
+            glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, 0, bytes, shortIndices.data());
+        }
+    } else {
+        indexType = GL_UNSIGNED_INT;
+        glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+    }
 
+    setupInstances();
     glBindVertexArray(0);
+    vertexCount = vertices.size();
+    indexCount = indices.size();
 }
 
-void Mesh::Draw(Shader &shader) {
+void Mesh::setupQuantizedAttributes() {
+    // setupBounds already found the box
+    const glm::vec3 minBounds = boundsMin;
+    const glm::vec3 maxBounds = boundsMax;
+    positionOffset = minBounds;
+    positionScale = maxBounds - minBounds;
+
+    // Quantized straight into the mapped buffer instead of a staging copy
+    const size_t bytes = vertices.size() * sizeof(PackedVertex);
+    glBufferData(GL_ARRAY_BUFFER, bytes, nullptr, GL_STATIC_DRAW);
+    void* mapped = bytes > 0 ? glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes,
+                                                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT) : nullptr;
+    if (mapped) {
+        quantizeVertices(vertices.data(), vertices.size(), minBounds, maxBounds, static_cast<PackedVertex*>(mapped));
+        glUnmapBuffer(GL_ARRAY_BUFFER);
+    } else if (bytes > 0) {
+        std::vector<PackedVertex> packed;
+        quantizeVertices(vertices, minBounds, maxBounds, packed);
+        glBufferSubData(GL_ARRAY_BUFFER, 0, bytes, packed.data());
+    }
+
+    // unorm16 positions relative to the mesh bounds
+    glEnableVertexAttribArray(0);
+    glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, position));
+    // snorm16 octahedral normals
+    glEnableVertexAttribArray(1);
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, normal));
+    // half-float texture coords
+    glEnableVertexAttribArray(2);
+    glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, sizeof(PackedVertex), (void*)offsetof(PackedVertex, texCoords));
+}
+
+void Mesh::setInstanceNodes(std::vector<uint32_t> nodes, uint64_t graphVersion) {
+    instanceNodes = std::move(nodes);
+    instanceVersion = graphVersion;
+}
+
+bool Mesh::refreshInstances(const SceneGraph& graph, bool all) {
+    if (instanceNodes.size() != instances.size() || (!all && instanceVersion == graph.getVersion())) {
+        return false;
+    }
+    // One version behind only needs the nodes that update moved, otherwise take them all
+    const bool missedUpdates = all || instanceVersion + 1 != graph.getVersion();
+    bool moved = false;
+    for (size_t i = 0; i < instanceNodes.size(); i++) {
+        const uint32_t node = instanceNodes[i];
+        if (node < graph.getNodeCount() && (missedUpdates || graph.wasUpdated(node))) {
+            instances[i] = graph.getWorldTransform(node);
+            moved = true;
+        }
+    }
+    instanceVersion = graph.getVersion();
+    if (!moved) {
+        return false;
+    }
+    if (instances.size() == 1) {
+        inverseInstance = glm::inverse(instances[0]);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, instances.size() * sizeof(glm::mat4), instances.data());
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+    return true;
+}
+
+void Mesh::setupInstances() {
+    if (instances.empty()) {
+        for (GLuint column = 0; column < 4; column++) {
+            glDisableVertexAttribArray(3 + column);
+        }
+        return;
+    }
+    if (instanceVBO == 0) {
+        glGenBuffers(1, &instanceVBO);
+    }
+    if (instances.size() == 1) {
+        inverseInstance = glm::inverse(instances[0]);
+    }
+    glBindBuffer(GL_ARRAY_BUFFER, instanceVBO);
+    glBufferData(GL_ARRAY_BUFFER, instances.size() * sizeof(glm::mat4), instances.data(), GL_DYNAMIC_DRAW);
+    // One mat4 attribute spans four vec4 locations, advanced once per instance
+    for (GLuint column = 0; column < 4; column++) {
+        glEnableVertexAttribArray(3 + column);
+        glVertexAttribPointer(3 + column, 4, GL_FLOAT, GL_FALSE, sizeof(glm::mat4),
+                              (void*)(column * sizeof(glm::vec4)));
+        glVertexAttribDivisor(3 + column, 1);
+    }
+}
+
+size_t Mesh::Draw(Shader &shader, size_t lod, const MeshletCullContext* cull) {
     // Set material properties from the first texture
     if (!textures.empty()) {
         shader.setVec3("objectColor", textures[0].diffuseColor);
@@ -38,6 +285,11 @@ void Mesh::Draw(Shader &shader) {
         shader.setFloat("shininess", textures[0].shininess);
     }
 
+    shader.setBool("quantized", vertexFormat == VertexFormat::Quantized);
+    shader.setVec3("positionOffset", positionOffset);
+    shader.setVec3("positionScale", positionScale);
+    shader.setBool("instanced", !instances.empty());
+
     // Bind appropriate textures
     unsigned int diffuseNr = 1;
     unsigned int specularNr = 1;
@@ -59,9 +311,48 @@ void Mesh::Draw(Shader &shader) {
     
     // Draw mesh
     glBindVertexArray(VAO);
-    glDrawElements(GL_TRIANGLES, indices.size(), GL_UNSIGNED_INT, 0);
+    const MeshLod& level = lods[std::min(lod, lods.size() - 1)];
+    size_t indexSize = indexType == GL_UNSIGNED_SHORT ? sizeof(unsigned short) : sizeof(unsigned int);
+    size_t triangles = 0;
+    if (instances.size() > 1) {
+        glDrawElementsInstanced(GL_TRIANGLES, static_cast<GLsizei>(level.indexCount), indexType,
+                                (void*)(level.indexOffset * indexSize), static_cast<GLsizei>(instances.size()));
+        triangles = level.indexCount / 3 * instances.size();
+    } else if (cull == nullptr || meshlets.empty()) {
+        glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(level.indexCount), indexType,
+                       (void*)(level.indexOffset * indexSize));
+        triangles = level.indexCount / 3;
+    } else {
+        // Meshlets are sorted by index offset, find the ones of this level
+        auto byOffset = [](const Meshlet& meshlet, unsigned int offset) { return meshlet.indexOffset < offset; };
+        auto first = std::lower_bound(meshlets.begin(), meshlets.end(), level.indexOffset, byOffset);
+        auto last = std::lower_bound(first, meshlets.end(), level.indexOffset + level.indexCount, byOffset);
+
+        drawCounts.clear();
+        drawOffsets.clear();
+        unsigned int runEnd = 0;
+        for (auto meshlet = first; meshlet != last; ++meshlet) {
+            if (!isMeshletVisible(*meshlet, *cull)) {
+                continue;
+            }
+            // Consecutive survivors become one draw
+            if (!drawCounts.empty() && meshlet->indexOffset == runEnd) {
+                drawCounts.back() += static_cast<GLsizei>(meshlet->indexCount);
+            } else {
+                drawCounts.push_back(static_cast<GLsizei>(meshlet->indexCount));
+                drawOffsets.push_back((const void*)(meshlet->indexOffset * indexSize));
+            }
+            runEnd = meshlet->indexOffset + meshlet->indexCount;
+            triangles += meshlet->indexCount / 3;
+        }
+        if (!drawCounts.empty()) {
+            glMultiDrawElements(GL_TRIANGLES, drawCounts.data(), indexType, drawOffsets.data(),
+                                static_cast<GLsizei>(drawCounts.size()));
+        }
+    }
     glBindVertexArray(0);
     
     // Reset to defaults
     glActiveTexture(GL_TEXTURE0);
+    return triangles;
 } 
\ No newline at end of file
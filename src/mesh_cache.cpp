@@ -0,0 +1,529 @@
+#include "mesh_cache.h"
+#include "hash.h"
+#include "log.h"
+#include "mapped_file.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char MAGIC[4] = { 'P', 'G', 'M', 'C' };
+const size_t ALIGNMENT = 16;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t vertexSize;
+    uint32_t importFlags;
+    uint32_t importProfile;
+    uint32_t processFlags;
+    uint32_t lodLevels;
+    float lodMaxError;
+    uint64_t sourceSize;
+    int64_t sourceMtime;
+    uint32_t meshCount;
+    uint32_t pathLength;
+    float minBounds[3];
+    float maxBounds[3];
+    // Scene graph: parent indices, then local transforms at the next aligned offset
+    uint32_t nodeCount;
+    uint64_t nodeOffset;
+};
+
+// One entry of the table of contents, offsets are from the start of the file
+struct MeshRecord {
+    uint64_t vertexOffset;
+    uint64_t vertexCount;
+    uint64_t indexOffset;
+    uint64_t indexCount;
+    uint64_t textureOffset;
+    uint32_t textureCount;
+    uint32_t lodCount;
+    uint64_t lodOffset;
+    uint64_t meshletOffset;
+    uint64_t meshletCount;
+    uint64_t instanceOffset;
+    uint64_t instanceCount;
+    uint64_t instanceNodeOffset;
+    uint64_t instanceNodeCount;
+    float minBounds[3];  // Every instance
+    float maxBounds[3];
+    float localMinBounds[3];  // The vertices alone
+    float localMaxBounds[3];
+};
+
+struct TextureRecord {
+    float diffuseColor[3];
+    float specularColor[3];
+    float shininess;
+    uint32_t typeLength;
+    uint32_t pathLength;
+};
+
+size_t alignUp(size_t offset) {
+    return (offset + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+}
+
+void writePadding(std::ofstream& out, size_t& offset, size_t target) {
+    static const char zeros[ALIGNMENT] = {};
+    out.write(zeros, static_cast<std::streamsize>(target - offset));
+    offset = target;
+}
+
+// Bounds-checked view into the mapped file
+template <typename T>
+const T* view(const MappedFile& file, uint64_t offset, uint64_t count = 1) {
+    if (offset > file.size() || count > (file.size() - offset) / sizeof(T)) {
+        return nullptr;
+    }
+    return reinterpret_cast<const T*>(file.data() + offset);
+}
+
+} // namespace
+
+MeshCache::MeshCache(std::string directory) : directory(std::move(directory)) {}
+
+bool MeshCache::makeKey(const std::string& sourcePath, unsigned int importFlags, unsigned int processFlags,
+                        MeshCacheKey& key) {
+    std::error_code ec;
+    uint64_t size = fs::file_size(sourcePath, ec);
+    if (ec) {
+        return false;
+    }
+    auto mtime = fs::last_write_time(sourcePath, ec);
+    if (ec) {
+        return false;
+    }
+    key.sourcePath = fs::absolute(sourcePath, ec).generic_string();
+    if (ec) {
+        key.sourcePath = sourcePath;
+    }
+    key.sourceSize = size;
+    key.sourceMtime = static_cast<int64_t>(mtime.time_since_epoch().count());
+    key.importFlags = importFlags;
+    key.processFlags = processFlags;
+    return true;
+}
+
+std::string MeshCache::entryPrefix(const MeshCacheKey& key) const {
+    uint64_t hash = fnv1a(key.sourcePath.data(), key.sourcePath.size());
+    hash = fnv1a(&key.importFlags, sizeof(key.importFlags), hash);
+    hash = fnv1a(&key.importProfile, sizeof(key.importProfile), hash);
+    hash = fnv1a(&key.processFlags, sizeof(key.processFlags), hash);
+    hash = fnv1a(&key.lodLevels, sizeof(key.lodLevels), hash);
+    hash = fnv1a(&key.lodMaxError, sizeof(key.lodMaxError), hash);
+    char name[24];
+    std::snprintf(name, sizeof(name), "%016llx-", static_cast<unsigned long long>(hash));
+    return name;
+}
+
+std::string MeshCache::entryPath(const MeshCacheKey& key) const {
+    // The source's size and timestamp are part of the name, so a new entry
+    // never has to replace one a streaming model still has mapped
+    uint64_t hash = fnv1a(&key.sourceSize, sizeof(key.sourceSize));
+    hash = fnv1a(&key.sourceMtime, sizeof(key.sourceMtime), hash);
+    char name[32];
+    std::snprintf(name, sizeof(name), "%016llx.meshcache", static_cast<unsigned long long>(hash));
+    return directory + "/" + entryPrefix(key) + name;
+}
+
+void MeshCache::removeStale(const MeshCacheKey& key) const {
+    const std::string prefix = entryPrefix(key);
+    const fs::path current = fs::path(entryPath(key)).filename();
+    std::error_code ec;
+    for (fs::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+        const fs::path name = it->path().filename();
+        if (name != current && name.extension() == ".meshcache" && name.string().compare(0, prefix.size(), prefix) == 0) {
+            // Still mapped by a model on some platforms, a later store retries
+            std::error_code removeError;
+            fs::remove(it->path(), removeError);
+        }
+    }
+}
+
+bool MeshCache::open(const MeshCacheKey& key, MeshCacheEntry& entry) const {
+    MappedFile file;
+    if (!file.open(entryPath(key))) {
+        return false;
+    }
+
+    const FileHeader* header = view<FileHeader>(file, 0);
+    if (!header || std::memcmp(header->magic, MAGIC, sizeof(MAGIC)) != 0 ||
+        header->version != VERSION || header->vertexSize != sizeof(Vertex)) {
+        LOG_INFO("Mesh cache entry is from an incompatible version, ignoring it");
+        return false;
+    }
+    const char* sourcePath = view<char>(file, sizeof(FileHeader), header->pathLength);
+    if (!sourcePath ||
+        key.sourcePath.compare(0, std::string::npos, sourcePath, header->pathLength) != 0 ||
+        header->sourceSize != key.sourceSize || header->sourceMtime != key.sourceMtime ||
+        header->importFlags != key.importFlags || header->importProfile != key.importProfile ||
+        header->processFlags != key.processFlags ||
+        header->lodLevels != key.lodLevels || header->lodMaxError != key.lodMaxError) {
+        LOG_INFO("Mesh cache entry is stale");
+        return false;
+    }
+
+    const uint64_t tocOffset = alignUp(sizeof(FileHeader) + header->pathLength);
+    if (!view<MeshRecord>(file, tocOffset, header->meshCount)) {
+        LOG_ERROR("ERROR::MESH_CACHE::OPEN: Truncated table of contents");
+        return false;
+    }
+    if (!view<int32_t>(file, header->nodeOffset, header->nodeCount) ||
+        !view<glm::mat4>(file, alignUp(header->nodeOffset + header->nodeCount * sizeof(int32_t)), header->nodeCount)) {
+        LOG_ERROR("ERROR::MESH_CACHE::OPEN: Truncated scene graph");
+        return false;
+    }
+
+    entry.tocOffset = tocOffset;
+    entry.meshCount = header->meshCount;
+    entry.nodeOffset = header->nodeOffset;
+    entry.nodeCount = header->nodeCount;
+    entry.minBounds = glm::vec3(header->minBounds[0], header->minBounds[1], header->minBounds[2]);
+    entry.maxBounds = glm::vec3(header->maxBounds[0], header->maxBounds[1], header->maxBounds[2]);
+    entry.file = std::move(file);
+    return true;
+}
+
+bool MeshCache::load(const MeshCacheKey& key, std::vector<MeshData>& meshes,
+                     glm::vec3& minBounds, glm::vec3& maxBounds, SceneGraph& nodes) const {
+    MeshCacheEntry entry;
+    if (!open(key, entry)) {
+        return false;
+    }
+
+    std::vector<MeshData> loaded(entry.getMeshCount());
+    for (size_t i = 0; i < loaded.size(); i++) {
+        if (!entry.readGeometry(i, loaded[i]) || !entry.readMaterials(i, loaded[i].textures)) {
+            return false;
+        }
+    }
+
+    minBounds = entry.getMinBounds();
+    maxBounds = entry.getMaxBounds();
+    meshes = std::move(loaded);
+    entry.readNodes(nodes);
+    return true;
+}
+
+void MeshCacheEntry::readNodes(SceneGraph& nodes) const {
+    // Validated by open()
+    const int32_t* parents = view<int32_t>(file, nodeOffset, nodeCount);
+    const glm::mat4* locals = view<glm::mat4>(file, alignUp(nodeOffset + nodeCount * sizeof(int32_t)), nodeCount);
+    nodes.clear();
+    nodes.reserve(nodeCount);
+    for (size_t i = 0; i < nodeCount; i++) {
+        nodes.addNode(parents[i], locals[i]);
+    }
+    nodes.update();
+}
+
+void MeshCacheEntry::getMeshBounds(size_t mesh, glm::vec3& meshMin, glm::vec3& meshMax) const {
+    const MeshRecord& record = view<MeshRecord>(file, tocOffset, meshCount)[mesh];
+    meshMin = glm::vec3(record.minBounds[0], record.minBounds[1], record.minBounds[2]);
+    meshMax = glm::vec3(record.maxBounds[0], record.maxBounds[1], record.maxBounds[2]);
+}
+
+size_t MeshCacheEntry::getGeometryBytes(size_t mesh) const {
+    const MeshRecord& record = view<MeshRecord>(file, tocOffset, meshCount)[mesh];
+    return static_cast<size_t>(record.vertexCount * sizeof(Vertex) + record.indexCount * sizeof(unsigned int) +
+                               record.lodCount * sizeof(MeshLod) + record.meshletCount * sizeof(Meshlet) +
+                               record.instanceCount * sizeof(glm::mat4) + record.instanceNodeCount * sizeof(uint32_t));
+}
+
+void MeshCacheEntry::releaseGeometry(size_t mesh) const {
+    const MeshRecord& record = view<MeshRecord>(file, tocOffset, meshCount)[mesh];
+    // Geometry arrays are laid out back to back in front of the materials
+    file.release(static_cast<size_t>(record.vertexOffset), static_cast<size_t>(record.textureOffset - record.vertexOffset));
+}
+
+bool MeshCacheEntry::readGeometry(size_t i, MeshData& mesh) const {
+    const MeshRecord& record = view<MeshRecord>(file, tocOffset, meshCount)[i];
+
+    const Vertex* vertices = view<Vertex>(file, record.vertexOffset, record.vertexCount);
+    const unsigned int* indices = view<unsigned int>(file, record.indexOffset, record.indexCount);
+    if (!vertices || !indices) {
+        LOG_ERROR("ERROR::MESH_CACHE::LOAD: Truncated geometry for mesh " << i);
+        return false;
+    }
+    mesh.vertices.assign(vertices, vertices + record.vertexCount);
+    // Checked in the copy loop, a damaged index would draw past the end of the vertex buffer
+    mesh.indices.resize(static_cast<size_t>(record.indexCount));
+    unsigned int maxIndex = 0;
+    for (size_t k = 0; k < mesh.indices.size(); k++) {
+        mesh.indices[k] = indices[k];
+        maxIndex = std::max(maxIndex, indices[k]);
+    }
+    if (!mesh.indices.empty() && maxIndex >= record.vertexCount) {
+        LOG_ERROR("ERROR::MESH_CACHE::LOAD: Index " << maxIndex << " of mesh " << i << " is past its "
+                  << record.vertexCount << " vertices");
+        return false;
+    }
+
+    const MeshLod* lods = view<MeshLod>(file, record.lodOffset, record.lodCount);
+    if (!lods) {
+        LOG_ERROR("ERROR::MESH_CACHE::LOAD: Truncated LOD table for mesh " << i);
+        return false;
+    }
+    for (uint32_t l = 0; l < record.lodCount; l++) {
+        if (uint64_t(lods[l].indexOffset) + lods[l].indexCount > record.indexCount) {
+            LOG_ERROR("ERROR::MESH_CACHE::LOAD: LOD " << l << " of mesh " << i << " is out of range");
+            return false;
+        }
+    }
+    mesh.lods.assign(lods, lods + record.lodCount);
+
+    const Meshlet* meshlets = view<Meshlet>(file, record.meshletOffset, record.meshletCount);
+    if (!meshlets) {
+        LOG_ERROR("ERROR::MESH_CACHE::LOAD: Truncated meshlets for mesh " << i);
+        return false;
+    }
+    for (uint64_t m = 0; m < record.meshletCount; m++) {
+        if (uint64_t(meshlets[m].indexOffset) + meshlets[m].indexCount > record.indexCount) {
+            LOG_ERROR("ERROR::MESH_CACHE::LOAD: Meshlet " << m << " of mesh " << i << " is out of range");
+            return false;
+        }
+    }
+    mesh.meshlets.assign(meshlets, meshlets + record.meshletCount);
+
+    const glm::mat4* instances = view<glm::mat4>(file, record.instanceOffset, record.instanceCount);
+    if (!instances) {
+        LOG_ERROR("ERROR::MESH_CACHE::LOAD: Truncated instances for mesh " << i);
+        return false;
+    }
+    mesh.instances.assign(instances, instances + record.instanceCount);
+
+    const uint32_t* instanceNodes = view<uint32_t>(file, record.instanceNodeOffset, record.instanceNodeCount);
+    if (!instanceNodes) {
+        LOG_ERROR("ERROR::MESH_CACHE::LOAD: Truncated instance nodes for mesh " << i);
+        return false;
+    }
+    // Every instance follows one node of the hierarchy stored with the entry
+    if (record.instanceNodeCount != record.instanceCount) {
+        LOG_ERROR("ERROR::MESH_CACHE::LOAD: Mesh " << i << " has " << record.instanceCount << " instances but "
+                  << record.instanceNodeCount << " instance nodes");
+        return false;
+    }
+    for (uint64_t n = 0; n < record.instanceNodeCount; n++) {
+        if (instanceNodes[n] >= nodeCount) {
+            LOG_ERROR("ERROR::MESH_CACHE::LOAD: Instance node " << instanceNodes[n] << " of mesh " << i
+                      << " is out of range");
+            return false;
+        }
+    }
+    mesh.instanceNodes.assign(instanceNodes, instanceNodes + record.instanceNodeCount);
+    mesh.minBounds = glm::vec3(record.minBounds[0], record.minBounds[1], record.minBounds[2]);
+    mesh.maxBounds = glm::vec3(record.maxBounds[0], record.maxBounds[1], record.maxBounds[2]);
+    mesh.localMinBounds = glm::vec3(record.localMinBounds[0], record.localMinBounds[1], record.localMinBounds[2]);
+    mesh.localMaxBounds = glm::vec3(record.localMaxBounds[0], record.localMaxBounds[1], record.localMaxBounds[2]);
+    return true;
+}
+
+bool MeshCacheEntry::readMaterials(size_t i, std::vector<Texture>& textures) const {
+    const MeshRecord& record = view<MeshRecord>(file, tocOffset, meshCount)[i];
+    textures.clear();
+    uint64_t offset = record.textureOffset;
+    for (uint32_t t = 0; t < record.textureCount; t++) {
+        const TextureRecord* texRecord = view<TextureRecord>(file, offset);
+        if (!texRecord) {
+            LOG_ERROR("ERROR::MESH_CACHE::LOAD: Truncated material for mesh " << i);
+            return false;
+        }
+        offset += sizeof(TextureRecord);
+        const char* strings = view<char>(file, offset, uint64_t(texRecord->typeLength) + texRecord->pathLength);
+        if (!strings) {
+            LOG_ERROR("ERROR::MESH_CACHE::LOAD: Truncated material for mesh " << i);
+            return false;
+        }
+        offset += texRecord->typeLength + texRecord->pathLength;
+
+        Texture texture;
+        texture.id = 0;
+        texture.type.assign(strings, texRecord->typeLength);
+        texture.path.assign(strings + texRecord->typeLength, texRecord->pathLength);
+        texture.diffuseColor = glm::vec3(texRecord->diffuseColor[0], texRecord->diffuseColor[1], texRecord->diffuseColor[2]);
+        texture.specularColor = glm::vec3(texRecord->specularColor[0], texRecord->specularColor[1], texRecord->specularColor[2]);
+        texture.shininess = texRecord->shininess;
+        textures.push_back(texture);
+    }
+    return true;
+}
+
+bool MeshCache::store(const MeshCacheKey& key, const std::vector<MeshData>& meshes,
+                      const glm::vec3& minBounds, const glm::vec3& maxBounds, const SceneGraph& nodes) const {
+    std::error_code ec;
+    fs::create_directories(directory, ec);
+    if (ec) {
+        LOG_ERROR("ERROR::MESH_CACHE::STORE: Cannot create cache directory " << directory << ": " << ec.message());
+        return false;
+    }
+
+    FileHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.vertexSize = sizeof(Vertex);
+    header.importFlags = key.importFlags;
+    header.importProfile = key.importProfile;
+    header.processFlags = key.processFlags;
+    header.lodLevels = key.lodLevels;
+    header.lodMaxError = key.lodMaxError;
+    header.sourceSize = key.sourceSize;
+    header.sourceMtime = key.sourceMtime;
+    header.meshCount = static_cast<uint32_t>(meshes.size());
+    header.pathLength = static_cast<uint32_t>(key.sourcePath.size());
+    for (int i = 0; i < 3; i++) {
+        header.minBounds[i] = minBounds[i];
+        header.maxBounds[i] = maxBounds[i];
+    }
+
+    // Lay out the file first so the table of contents can be written up front
+    size_t offset = alignUp(sizeof(FileHeader) + key.sourcePath.size());
+    const size_t tocOffset = offset;
+    offset += meshes.size() * sizeof(MeshRecord);
+
+    offset = alignUp(offset);
+    header.nodeCount = static_cast<uint32_t>(nodes.getNodeCount());
+    header.nodeOffset = offset;
+    offset += nodes.getNodeCount() * sizeof(int32_t);
+    const size_t nodeTransformOffset = alignUp(offset);
+    offset = nodeTransformOffset + nodes.getNodeCount() * sizeof(glm::mat4);
+
+    std::vector<MeshRecord> records(meshes.size());
+    for (size_t i = 0; i < meshes.size(); i++) {
+        const MeshData& mesh = meshes[i];
+        MeshRecord& record = records[i];
+        record = {};
+        for (int c = 0; c < 3; c++) {
+            record.minBounds[c] = mesh.minBounds[c];
+            record.maxBounds[c] = mesh.maxBounds[c];
+            record.localMinBounds[c] = mesh.localMinBounds[c];
+            record.localMaxBounds[c] = mesh.localMaxBounds[c];
+        }
+
+        offset = alignUp(offset);
+        record.vertexOffset = offset;
+        record.vertexCount = mesh.vertices.size();
+        offset += mesh.vertices.size() * sizeof(Vertex);
+
+        offset = alignUp(offset);
+        record.indexOffset = offset;
+        record.indexCount = mesh.indices.size();
+        offset += mesh.indices.size() * sizeof(unsigned int);
+
+        offset = alignUp(offset);
+        record.lodOffset = offset;
+        record.lodCount = static_cast<uint32_t>(mesh.lods.size());
+        offset += mesh.lods.size() * sizeof(MeshLod);
+
+        offset = alignUp(offset);
+        record.meshletOffset = offset;
+        record.meshletCount = mesh.meshlets.size();
+        offset += mesh.meshlets.size() * sizeof(Meshlet);
+
+        offset = alignUp(offset);
+        record.instanceOffset = offset;
+        record.instanceCount = mesh.instances.size();
+        offset += mesh.instances.size() * sizeof(glm::mat4);
+
+        offset = alignUp(offset);
+        record.instanceNodeOffset = offset;
+        record.instanceNodeCount = mesh.instanceNodes.size();
+        offset += mesh.instanceNodes.size() * sizeof(uint32_t);
+
+        record.textureOffset = offset;
+        record.textureCount = static_cast<uint32_t>(mesh.textures.size());
+        for (const Texture& texture : mesh.textures) {
+            offset += sizeof(TextureRecord) + texture.type.size() + texture.path.size();
+        }
+    }
+
+    // Write to a temporary file and rename so readers never see a partial entry
+    const std::string path = entryPath(key);
+    const std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            LOG_ERROR("ERROR::MESH_CACHE::STORE: Cannot open " << tempPath << " for writing");
+            return false;
+        }
+
+        size_t written = 0;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        out.write(key.sourcePath.data(), static_cast<std::streamsize>(key.sourcePath.size()));
+        written += sizeof(header) + key.sourcePath.size();
+        writePadding(out, written, tocOffset);
+        out.write(reinterpret_cast<const char*>(records.data()), static_cast<std::streamsize>(records.size() * sizeof(MeshRecord)));
+        written += records.size() * sizeof(MeshRecord);
+
+        writePadding(out, written, header.nodeOffset);
+        out.write(reinterpret_cast<const char*>(nodes.getParents().data()), static_cast<std::streamsize>(nodes.getNodeCount() * sizeof(int32_t)));
+        written += nodes.getNodeCount() * sizeof(int32_t);
+        writePadding(out, written, nodeTransformOffset);
+        out.write(reinterpret_cast<const char*>(nodes.getLocalTransforms().data()), static_cast<std::streamsize>(nodes.getNodeCount() * sizeof(glm::mat4)));
+        written += nodes.getNodeCount() * sizeof(glm::mat4);
+
+        for (size_t i = 0; i < meshes.size(); i++) {
+            const MeshData& mesh = meshes[i];
+            writePadding(out, written, records[i].vertexOffset);
+            out.write(reinterpret_cast<const char*>(mesh.vertices.data()), static_cast<std::streamsize>(mesh.vertices.size() * sizeof(Vertex)));
+            written += mesh.vertices.size() * sizeof(Vertex);
+
+            writePadding(out, written, records[i].indexOffset);
+            out.write(reinterpret_cast<const char*>(mesh.indices.data()), static_cast<std::streamsize>(mesh.indices.size() * sizeof(unsigned int)));
+            written += mesh.indices.size() * sizeof(unsigned int);
+
+            writePadding(out, written, records[i].lodOffset);
+            out.write(reinterpret_cast<const char*>(mesh.lods.data()), static_cast<std::streamsize>(mesh.lods.size() * sizeof(MeshLod)));
+            written += mesh.lods.size() * sizeof(MeshLod);
+
+            writePadding(out, written, records[i].meshletOffset);
+            out.write(reinterpret_cast<const char*>(mesh.meshlets.data()), static_cast<std::streamsize>(mesh.meshlets.size() * sizeof(Meshlet)));
+            written += mesh.meshlets.size() * sizeof(Meshlet);
+
+            writePadding(out, written, records[i].instanceOffset);
+            out.write(reinterpret_cast<const char*>(mesh.instances.data()), static_cast<std::streamsize>(mesh.instances.size() * sizeof(glm::mat4)));
+            written += mesh.instances.size() * sizeof(glm::mat4);
+
+            writePadding(out, written, records[i].instanceNodeOffset);
+            out.write(reinterpret_cast<const char*>(mesh.instanceNodes.data()), static_cast<std::streamsize>(mesh.instanceNodes.size() * sizeof(uint32_t)));
+            written += mesh.instanceNodes.size() * sizeof(uint32_t);
+
+            for (const Texture& texture : mesh.textures) {
+                TextureRecord texRecord = {};
+                for (int c = 0; c < 3; c++) {
+                    texRecord.diffuseColor[c] = texture.diffuseColor[c];
+                    texRecord.specularColor[c] = texture.specularColor[c];
+                }
+                texRecord.shininess = texture.shininess;
+                texRecord.typeLength = static_cast<uint32_t>(texture.type.size());
+                texRecord.pathLength = static_cast<uint32_t>(texture.path.size());
+                out.write(reinterpret_cast<const char*>(&texRecord), sizeof(texRecord));
+                out.write(texture.type.data(), static_cast<std::streamsize>(texture.type.size()));
+                out.write(texture.path.data(), static_cast<std::streamsize>(texture.path.size()));
+                written += sizeof(texRecord) + texture.type.size() + texture.path.size();
+            }
+        }
+
+        if (!out) {
+            LOG_ERROR("ERROR::MESH_CACHE::STORE: Failed writing " << tempPath);
+            out.close();
+            fs::remove(tempPath, ec);
+            return false;
+        }
+    }
+
+    fs::rename(tempPath, path, ec);
+    if (ec) {
+        LOG_ERROR("ERROR::MESH_CACHE::STORE: Cannot replace " << path << ": " << ec.message());
+        fs::remove(tempPath, ec);
+        return false;
+    }
+    LOG_INFO("Wrote mesh cache entry: " << path);
+    removeStale(key);
+    return true;
+}
@@ -0,0 +1,265 @@
+#include "mesh_optimizer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+
+namespace {
+
+const int SCORE_CACHE_SIZE = 32;
+const unsigned int OVERDRAW_CACHE_SIZE = 16;
+
+// Forsyth's vertex score: recently used vertices and vertices with few
+// remaining triangles are preferred
+float vertexScore(int cachePosition, unsigned int liveTriangles) {
+    if (liveTriangles == 0) {
+        return -1.0f;
+    }
+    float score = 0.0f;
+    if (cachePosition >= 0) {
+        if (cachePosition < 3) {
+            // The last triangle's vertices get a fixed score so we don't just reuse them
+            score = 0.75f;
+        } else {
+            const float scaler = 1.0f / (SCORE_CACHE_SIZE - 3);
+            score = std::pow(1.0f - (cachePosition - 3) * scaler, 1.5f);
+        }
+    }
+    return score + 2.0f / std::sqrt(static_cast<float>(liveTriangles));
+}
+
+} // namespace
+
+VertexCacheStats analyzeVertexCache(const std::vector<unsigned int>& indices, size_t vertexCount,
+                                    unsigned int cacheSize) {
+    VertexCacheStats stats;
+    stats.triangles = indices.size() / 3;
+
+    // A vertex is cached while fewer than cacheSize misses happened since it was loaded
+    std::vector<size_t> loadedAt(vertexCount, 0);
+    std::vector<bool> seen(vertexCount, false);
+    size_t clock = cacheSize + 1;
+    for (unsigned int index : indices) {
+        if (!seen[index]) {
+            seen[index] = true;
+            stats.vertices++;
+        }
+        if (clock - loadedAt[index] > cacheSize) {
+            loadedAt[index] = clock++;
+            stats.transformed++;
+        }
+    }
+    return stats;
+}
+
+void optimizeVertexCache(std::vector<unsigned int>& indices, size_t vertexCount) {
+    optimizeVertexCache(indices.data(), indices.size(), vertexCount);
+}
+
+void optimizeVertexCache(unsigned int* indices, size_t indexCount, size_t vertexCount) {
+    const size_t triangleCount = indexCount / 3;
+    if (triangleCount < 2) {
+        return;
+    }
+
+    // Vertex -> triangle adjacency, the live triangles of v are adjacency[offsets[v], offsets[v] + live[v])
+    std::vector<unsigned int> live(vertexCount, 0);
+    for (size_t i = 0; i < indexCount; i++) {
+        live[indices[i]]++;
+    }
+    std::vector<size_t> offsets(vertexCount + 1, 0);
+    for (size_t v = 0; v < vertexCount; v++) {
+        offsets[v + 1] = offsets[v] + live[v];
+    }
+    std::vector<unsigned int> adjacency(indexCount);
+    {
+        std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+        for (size_t i = 0; i < indexCount; i++) {
+            adjacency[fill[indices[i]]++] = static_cast<unsigned int>(i / 3);
+        }
+    }
+
+    std::vector<int> cachePosition(vertexCount, -1);
+    std::vector<float> score(vertexCount);
+    for (size_t v = 0; v < vertexCount; v++) {
+        score[v] = vertexScore(-1, live[v]);
+    }
+    std::vector<float> triangleScore(triangleCount);
+    for (size_t t = 0; t < triangleCount; t++) {
+        triangleScore[t] = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+    }
+
+    std::vector<bool> emitted(triangleCount, false);
+    std::vector<unsigned int> result;
+    result.reserve(indexCount);
+    std::vector<unsigned int> cache, nextCache;
+    cache.reserve(SCORE_CACHE_SIZE + 3);
+    nextCache.reserve(SCORE_CACHE_SIZE + 3);
+
+    size_t best = 0;
+    float bestScore = -1.0f;
+    for (size_t t = 0; t < triangleCount; t++) {
+        if (triangleScore[t] > bestScore) {
+            bestScore = triangleScore[t];
+            best = t;
+        }
+    }
+
+    size_t inputCursor = 0;
+    for (size_t emittedCount = 0; emittedCount < triangleCount; emittedCount++) {
+        if (bestScore < 0.0f) {
+            // Dead end: continue with the next unemitted triangle in input order
+            while (emitted[inputCursor]) {
+                inputCursor++;
+            }
+            best = inputCursor;
+        }
+
+        const unsigned int* tri = &indices[best * 3];
+        emitted[best] = true;
+        result.insert(result.end(), tri, tri + 3);
+
+        // Retire the triangle from its vertices' live lists
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = tri[k];
+            unsigned int* begin = &adjacency[offsets[v]];
+            unsigned int* end = begin + live[v];
+            unsigned int* it = std::find(begin, end, static_cast<unsigned int>(best));
+            if (it != end) {
+                std::swap(*it, *(end - 1));
+                live[v]--;
+            }
+        }
+
+        // LRU: the triangle's vertices move to the front
+        nextCache.assign(tri, tri + 3);
+        for (unsigned int v : cache) {
+            if (v != tri[0] && v != tri[1] && v != tri[2]) {
+                nextCache.push_back(v);
+            }
+        }
+
+        // Rescore everything that was or is in the cache
+        for (size_t i = 0; i < nextCache.size(); i++) {
+            unsigned int v = nextCache[i];
+            cachePosition[v] = i < static_cast<size_t>(SCORE_CACHE_SIZE) ? static_cast<int>(i) : -1;
+            score[v] = vertexScore(cachePosition[v], live[v]);
+        }
+
+        bestScore = -1.0f;
+        for (size_t i = 0; i < nextCache.size() && i < static_cast<size_t>(SCORE_CACHE_SIZE); i++) {
+            unsigned int v = nextCache[i];
+            for (size_t a = offsets[v]; a < offsets[v] + live[v]; a++) {
+                unsigned int t = adjacency[a];
+                float s = score[indices[t * 3]] + score[indices[t * 3 + 1]] + score[indices[t * 3 + 2]];
+                triangleScore[t] = s;
+                if (s > bestScore) {
+                    bestScore = s;
+                    best = t;
+                }
+            }
+        }
+
+        if (nextCache.size() > static_cast<size_t>(SCORE_CACHE_SIZE)) {
+            nextCache.resize(SCORE_CACHE_SIZE);
+        }
+        std::swap(cache, nextCache);
+    }
+
+    std::copy(result.begin(), result.end(), indices);
+}
+
+void optimizeOverdraw(std::vector<unsigned int>& indices, const std::vector<Vertex>& vertices) {
+    const size_t triangleCount = indices.size() / 3;
+    if (triangleCount < 2 || vertices.empty()) {
+        return;
+    }
+
+    // Cluster boundaries: triangles where all three vertices miss the cache,
+    // i.e. the cache effectively restarted and reordering costs nothing
+    std::vector<size_t> clusterStarts;
+    std::vector<size_t> loadedAt(vertices.size(), 0);
+    size_t clock = OVERDRAW_CACHE_SIZE + 1;
+    for (size_t t = 0; t < triangleCount; t++) {
+        int misses = 0;
+        for (int k = 0; k < 3; k++) {
+            unsigned int v = indices[t * 3 + k];
+            if (clock - loadedAt[v] > OVERDRAW_CACHE_SIZE) {
+                loadedAt[v] = clock++;
+                misses++;
+            }
+        }
+        if (t == 0 || misses == 3) {
+            clusterStarts.push_back(t);
+        }
+    }
+    if (clusterStarts.size() < 2) {
+        return;
+    }
+    clusterStarts.push_back(triangleCount);
+
+    glm::vec3 meshCentroid(0.0f);
+    for (const Vertex& vertex : vertices) {
+        meshCentroid += vertex.Position;
+    }
+    meshCentroid /= static_cast<float>(vertices.size());
+
+    // Sort key: how far the cluster sits out along its own facing direction
+    const size_t clusterCount = clusterStarts.size() - 1;
+    std::vector<float> sortKey(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++) {
+        glm::vec3 centroid(0.0f);
+        glm::vec3 normal(0.0f);
+        float area = 0.0f;
+        for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++) {
+            const glm::vec3& a = vertices[indices[t * 3]].Position;
+            const glm::vec3& b = vertices[indices[t * 3 + 1]].Position;
+            const glm::vec3& d = vertices[indices[t * 3 + 2]].Position;
+            glm::vec3 faceNormal = glm::cross(b - a, d - a);
+            float faceArea = glm::length(faceNormal);
+            centroid += (a + b + d) * (faceArea / 3.0f);
+            normal += faceNormal;
+            area += faceArea;
+        }
+        float normalLength = glm::length(normal);
+        if (area <= 0.0f || normalLength <= 0.0f) {
+            sortKey[c] = std::numeric_limits<float>::lowest();
+            continue;
+        }
+        centroid /= area;
+        sortKey[c] = glm::dot(centroid - meshCentroid, normal / normalLength);
+    }
+
+    std::vector<size_t> order(clusterCount);
+    for (size_t c = 0; c < clusterCount; c++) {
+        order[c] = c;
+    }
+    std::stable_sort(order.begin(), order.end(), [&](size_t a, size_t b) { return sortKey[a] > sortKey[b]; });
+
+    std::vector<unsigned int> result;
+    result.reserve(indices.size());
+    for (size_t c : order) {
+        result.insert(result.end(), indices.begin() + clusterStarts[c] * 3, indices.begin() + clusterStarts[c + 1] * 3);
+    }
+    indices.swap(result);
+}
+
+void optimizeVertexFetch(std::vector<Vertex>& vertices, std::vector<unsigned int>& indices) {
+    const unsigned int unused = std::numeric_limits<unsigned int>::max();
+    std::vector<unsigned int> remap(vertices.size(), unused);
+    unsigned int next = 0;
+    for (unsigned int& index : indices) {
+        if (remap[index] == unused) {
+            remap[index] = next++;
+        }
+        index = remap[index];
+    }
+
+    std::vector<Vertex> reordered(next);
+    for (size_t v = 0; v < vertices.size(); v++) {
+        if (remap[v] != unused) {
+            reordered[remap[v]] = vertices[v];
+        }
+    }
+    vertices.swap(reordered);
+}
@@ -0,0 +1,332 @@
+#include "mesh_simplify.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+namespace {
+
+// Symmetric 4x4 plane quadric, upper triangle only
+struct Quadric {
+    double a2 = 0, ab = 0, ac = 0, ad = 0;
+    double b2 = 0, bc = 0, bd = 0;
+    double c2 = 0, cd = 0;
+    double d2 = 0;
+    double weight = 0;
+
+    void addPlane(double a, double b, double c, double d, double w) {
+        a2 += a * a * w; ab += a * b * w; ac += a * c * w; ad += a * d * w;
+        b2 += b * b * w; bc += b * c * w; bd += b * d * w;
+        c2 += c * c * w; cd += c * d * w;
+        d2 += d * d * w;
+        weight += w;
+    }
+
+    void add(const Quadric& q) {
+        a2 += q.a2; ab += q.ab; ac += q.ac; ad += q.ad;
+        b2 += q.b2; bc += q.bc; bd += q.bd;
+        c2 += q.c2; cd += q.cd;
+        d2 += q.d2;
+        weight += q.weight;
+    }
+
+    // Weighted sum of squared distances to the accumulated planes
+    double evaluate(const glm::vec3& p) const {
+        double x = p.x, y = p.y, z = p.z;
+        return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+             + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+             + c2 * z * z + 2 * cd * z
+             + d2;
+    }
+};
+
+struct Collapse {
+    unsigned int from;
+    unsigned int to;
+    double cost;
+};
+
+// Position bit pattern and the vertex it came from, sorted to find shared positions
+struct PositionKey {
+    uint32_t bits[3];
+    unsigned int vertex;
+
+    bool samePosition(const PositionKey& other) const {
+        return bits[0] == other.bits[0] && bits[1] == other.bits[1] && bits[2] == other.bits[2];
+    }
+    bool operator<(const PositionKey& other) const {
+        if (bits[0] != other.bits[0]) return bits[0] < other.bits[0];
+        if (bits[1] != other.bits[1]) return bits[1] < other.bits[1];
+        if (bits[2] != other.bits[2]) return bits[2] < other.bits[2];
+        return vertex < other.vertex;
+    }
+};
+
+uint64_t edgeKey(unsigned int a, unsigned int b) {
+    return a < b ? (uint64_t(a) << 32) | b : (uint64_t(b) << 32) | a;
+}
+
+glm::vec3 faceNormal(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c) {
+    return glm::cross(b - a, c - a);
+}
+
+} // namespace
+
+std::vector<unsigned int> simplifyMesh(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                       size_t targetIndexCount, float targetError, float* resultError) {
+    std::vector<unsigned int> result(indices);
+    double maxCostReached = 0.0;
+    const size_t vertexCount = vertices.size();
+    if (result.size() < 6 || vertexCount == 0) {
+        if (resultError) {
+            *resultError = 0.0f;
+        }
+        return result;
+    }
+
+    // Vertices that only differ in normal or texture coordinates share a position,
+    // represented by the lowest such vertex. Sorted keys instead of a hash map
+    // keep this to one allocation rather than one per vertex.
+    std::vector<unsigned int> position(vertexCount);
+    std::vector<unsigned int> wedges(vertexCount, 0);
+    {
+        std::vector<PositionKey> keys(vertexCount);
+        for (unsigned int v = 0; v < vertexCount; v++) {
+            std::memcpy(keys[v].bits, &vertices[v].Position, sizeof(keys[v].bits));
+            keys[v].vertex = v;
+        }
+        std::sort(keys.begin(), keys.end());
+        for (size_t first = 0, i = 0; i < vertexCount; i++) {
+            if (!keys[i].samePosition(keys[first])) {
+                first = i;
+            }
+            position[keys[i].vertex] = keys[first].vertex;
+            wedges[keys[first].vertex]++;
+        }
+    }
+
+    glm::vec3 minBounds(std::numeric_limits<float>::max());
+    glm::vec3 maxBounds(std::numeric_limits<float>::lowest());
+    for (unsigned int index : result) {
+        minBounds = glm::min(minBounds, vertices[index].Position);
+        maxBounds = glm::max(maxBounds, vertices[index].Position);
+    }
+    const double radius = glm::length(maxBounds - minBounds) * 0.5;
+    const double maxCost = (targetError * radius) * (targetError * radius);
+
+    // Lock seams, open borders and non-manifold edges so the outline and UV layout stay intact
+    std::vector<char> locked(vertexCount, 0);
+    {
+        // Sorted edge keys, every run is one edge and its length the number of uses
+        std::vector<uint64_t> edges;
+        edges.reserve(result.size());
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (int k = 0; k < 3; k++) {
+                unsigned int a = position[result[i + k]];
+                unsigned int b = position[result[i + (k + 1) % 3]];
+                if (a != b) {
+                    edges.push_back(edgeKey(a, b));
+                }
+            }
+        }
+        std::sort(edges.begin(), edges.end());
+        for (size_t first = 0; first < edges.size();) {
+            size_t end = first + 1;
+            while (end < edges.size() && edges[end] == edges[first]) {
+                end++;
+            }
+            if (end - first != 2) {
+                locked[edges[first] >> 32] = 1;
+                locked[edges[first] & 0xffffffffu] = 1;
+            }
+            first = end;
+        }
+        for (unsigned int v = 0; v < vertexCount; v++) {
+            if (wedges[position[v]] > 1 || locked[position[v]]) {
+                locked[v] = 1;
+            }
+        }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for (size_t i = 0; i < result.size(); i += 3) {
+        const glm::vec3& p0 = vertices[result[i]].Position;
+        glm::vec3 normal = faceNormal(p0, vertices[result[i + 1]].Position, vertices[result[i + 2]].Position);
+        double length = glm::length(normal);
+        if (length <= 0.0) {
+            continue;
+        }
+        double a = normal.x / length, b = normal.y / length, c = normal.z / length;
+        double d = -(a * p0.x + b * p0.y + c * p0.z);
+        double area = length * 0.5;
+        for (int k = 0; k < 3; k++) {
+            quadrics[result[i + k]].addPlane(a, b, c, d, area);
+        }
+    }
+
+    std::vector<Collapse> collapses;
+    std::vector<unsigned int> remap(vertexCount);
+    std::vector<char> touched(vertexCount);
+    std::vector<size_t> offsets(vertexCount + 1);
+    std::vector<unsigned int> adjacency;
+
+    // Each pass collapses a batch of cheapest independent edges, then compacts the index list
+    while (result.size() > targetIndexCount) {
+        collapses.clear();
+        for (size_t i = 0; i < result.size(); i += 3) {
+            for (int k = 0; k < 3; k++) {
+                unsigned int a = result[i + k];
+                unsigned int b = result[i + (k + 1) % 3];
+                if (position[a] == position[b]) {
+                    continue;
+                }
+                Quadric q = quadrics[a];
+                q.add(quadrics[b]);
+                double scale = q.weight > 0.0 ? 1.0 / q.weight : 0.0;
+                if (!locked[a]) {
+                    collapses.push_back({ a, b, std::max(0.0, q.evaluate(vertices[b].Position) * scale) });
+                }
+                if (!locked[b]) {
+                    collapses.push_back({ b, a, std::max(0.0, q.evaluate(vertices[a].Position) * scale) });
+                }
+            }
+        }
+        if (collapses.empty()) {
+            break;
+        }
+        std::sort(collapses.begin(), collapses.end(),
+                  [](const Collapse& x, const Collapse& y) { return x.cost < y.cost; });
+
+        // Vertex -> triangle adjacency for the flip test
+        std::fill(offsets.begin(), offsets.end(), 0);
+        for (unsigned int index : result) {
+            offsets[index + 1]++;
+        }
+        for (size_t v = 0; v < vertexCount; v++) {
+            offsets[v + 1] += offsets[v];
+        }
+        adjacency.resize(result.size());
+        {
+            std::vector<size_t> fill(offsets.begin(), offsets.end() - 1);
+            for (size_t i = 0; i < result.size(); i++) {
+                adjacency[fill[result[i]]++] = static_cast<unsigned int>(i / 3);
+            }
+        }
+
+        for (unsigned int v = 0; v < vertexCount; v++) {
+            remap[v] = v;
+        }
+        std::fill(touched.begin(), touched.end(), 0);
+
+        // Every collapse removes about two triangles
+        const size_t collapseLimit = (result.size() - targetIndexCount) / 6 + 1;
+        size_t applied = 0;
+        for (const Collapse& collapse : collapses) {
+            if (collapse.cost > maxCost || applied >= collapseLimit) {
+                break;
+            }
+            if (touched[collapse.from] || touched[collapse.to]) {
+                continue;
+            }
+
+            // Reject collapses that would fold a surviving triangle over
+            const glm::vec3& target = vertices[collapse.to].Position;
+            bool flips = false;
+            for (size_t a = offsets[collapse.from]; a < offsets[collapse.from + 1] && !flips; a++) {
+                const unsigned int* tri = &result[adjacency[a] * 3];
+                if (position[tri[0]] == position[collapse.to] || position[tri[1]] == position[collapse.to] ||
+                    position[tri[2]] == position[collapse.to]) {
+                    continue;
+                }
+                glm::vec3 p[3];
+                glm::vec3 moved[3];
+                for (int k = 0; k < 3; k++) {
+                    p[k] = vertices[tri[k]].Position;
+                    moved[k] = tri[k] == collapse.from ? target : p[k];
+                }
+                if (glm::dot(faceNormal(p[0], p[1], p[2]), faceNormal(moved[0], moved[1], moved[2])) <= 0.0f) {
+                    flips = true;
+                }
+            }
+            if (flips) {
+                continue;
+            }
+
+            // Freeze the one-ring so no other collapse this pass invalidates the test above
+            for (size_t a = offsets[collapse.from]; a < offsets[collapse.from + 1]; a++) {
+                const unsigned int* tri = &result[adjacency[a] * 3];
+                touched[tri[0]] = touched[tri[1]] = touched[tri[2]] = 1;
+            }
+            touched[collapse.to] = 1;
+
+            remap[collapse.from] = collapse.to;
+            quadrics[collapse.to].add(quadrics[collapse.from]);
+            maxCostReached = std::max(maxCostReached, collapse.cost);
+            applied++;
+        }
+        if (applied == 0) {
+            break;
+        }
+
+        // Drop triangles that became degenerate
+        size_t write = 0;
+        for (size_t i = 0; i < result.size(); i += 3) {
+            unsigned int a = remap[result[i]];
+            unsigned int b = remap[result[i + 1]];
+            unsigned int c = remap[result[i + 2]];
+            if (position[a] == position[b] || position[b] == position[c] || position[a] == position[c]) {
+                continue;
+            }
+            result[write++] = a;
+            result[write++] = b;
+            result[write++] = c;
+        }
+        result.resize(write);
+    }
+
+    if (resultError) {
+        *resultError = radius > 0.0 ? static_cast<float>(std::sqrt(maxCostReached) / radius) : 0.0f;
+    }
+    return result;
+}
+
+void buildLodChain(const std::vector<Vertex>& vertices, std::vector<unsigned int>& indices,
+                   std::vector<MeshLod>& lods, unsigned int levels, float maxError) {
+    lods.clear();
+    MeshLod full;
+    full.indexCount = static_cast<unsigned int>(indices.size());
+    lods.push_back(full);
+
+    // Each level is simplified from the previous one, so the errors add up.
+    // Levels are kept apart until the end so indices grows exactly once.
+    std::vector<std::vector<unsigned int>> simplifiedLevels;
+    size_t totalIndices = indices.size();
+    float error = 0.0f;
+    for (unsigned int level = 1; level <= levels; level++) {
+        if (error >= maxError) {
+            break;
+        }
+        const std::vector<unsigned int>& source = simplifiedLevels.empty() ? indices : simplifiedLevels.back();
+        size_t target = (source.size() / 6) * 3;
+        float levelError = 0.0f;
+        std::vector<unsigned int> simplified = simplifyMesh(vertices, source, target, maxError - error, &levelError);
+        // Not worth a level of its own if it barely got smaller
+        if (simplified.empty() || simplified.size() > source.size() * 9 / 10) {
+            break;
+        }
+        error += levelError;
+
+        MeshLod lod;
+        lod.indexOffset = static_cast<unsigned int>(totalIndices);
+        lod.indexCount = static_cast<unsigned int>(simplified.size());
+        lod.error = error;
+        lods.push_back(lod);
+        totalIndices += simplified.size();
+        simplifiedLevels.push_back(std::move(simplified));
+    }
+
+    indices.reserve(totalIndices);
+    for (const auto& simplified : simplifiedLevels) {
+        indices.insert(indices.end(), simplified.begin(), simplified.end());
+    }
+}
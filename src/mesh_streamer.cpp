@@ -0,0 +1,143 @@
+#include "mesh_streamer.h"
+#include "log.h"
+#include <algorithm>
+
+MeshStreamer::MeshStreamer(MeshCacheEntry entry, VertexFormat format, const StreamingBudget& budget)
+    : entry(std::move(entry)), format(format), budget(budget), pager(1) {
+    chunks.resize(this->entry.getMeshCount());
+    for (size_t i = 0; i < chunks.size(); i++) {
+        Chunk& chunk = chunks[i];
+        glm::vec3 meshMin, meshMax;
+        this->entry.getMeshBounds(i, meshMin, meshMax);
+        chunk.center = (meshMin + meshMax) * 0.5f;
+        chunk.radius = glm::length(meshMax - meshMin) * 0.5f;
+        chunk.bytes = this->entry.getGeometryBytes(i);
+        if (!this->entry.readMaterials(i, chunk.textures)) {
+            chunk.failed = true;
+        }
+    }
+}
+
+MeshStreamer::~MeshStreamer() {
+    // In-flight reads push into the queue, let them finish first
+    pager.wait();
+}
+
+Mesh* MeshStreamer::getVisibleMesh(size_t chunk) {
+    return chunks[chunk].visible ? chunks[chunk].mesh.get() : nullptr;
+}
+
+void MeshStreamer::update(const Frustum& frustum, const glm::vec3& cameraPosition, size_t uploadBudget) {
+    frame++;
+    uploadPaged(uploadBudget);
+
+    missing.clear();
+    for (size_t i = 0; i < chunks.size(); i++) {
+        Chunk& chunk = chunks[i];
+        chunk.visible = frustum.intersectsSphere(chunk.center, chunk.radius);
+        if (!chunk.visible) {
+            continue;
+        }
+        chunk.lastVisibleFrame = frame;
+        if (!chunk.mesh && !chunk.requested && !chunk.failed) {
+            missing.push_back(i);
+        }
+    }
+
+    // Budgets may have been lowered since the last frame
+    while (gpuBytes > budget.gpuBytes && evictOne()) {
+    }
+
+    // Nearest first, they cover the most of the screen
+    std::sort(missing.begin(), missing.end(), [&](size_t a, size_t b) {
+        return glm::length(chunks[a].center - cameraPosition) - chunks[a].radius <
+               glm::length(chunks[b].center - cameraPosition) - chunks[b].radius;
+    });
+    for (size_t i : missing) {
+        if (inFlight >= MAX_IN_FLIGHT) {
+            break;
+        }
+        const size_t bytes = chunks[i].bytes;
+        while (gpuBytes + bytes > budget.gpuBytes && evictOne()) {
+        }
+        if (cpuBytes + bytes > budget.cpuBytes || gpuBytes + bytes > budget.gpuBytes) {
+            // Everything resident is visible or too much waits for upload, the rest of the view has to wait
+            break;
+        }
+        request(i);
+    }
+}
+
+void MeshStreamer::request(size_t i) {
+    Chunk& chunk = chunks[i];
+    chunk.requested = true;
+    cpuBytes += chunk.bytes;
+    inFlight++;
+    pager.submit([this, i] {
+        PagedChunk result;
+        result.chunk = i;
+        result.ok = entry.readGeometry(i, result.data);
+        // The copy is all we need, don't let the mapping hold the pages too
+        entry.releaseGeometry(i);
+        std::lock_guard<std::mutex> lock(pagedMutex);
+        paged.push_back(std::move(result));
+    });
+}
+
+void MeshStreamer::uploadPaged(size_t uploadBudget) {
+    size_t spent = 0;
+    while (spent < uploadBudget) {
+        PagedChunk result;
+        {
+            std::lock_guard<std::mutex> lock(pagedMutex);
+            if (paged.empty()) {
+                break;
+            }
+            result = std::move(paged.front());
+            paged.pop_front();
+        }
+
+        Chunk& chunk = chunks[result.chunk];
+        chunk.requested = false;
+        inFlight--;
+        if (!result.ok) {
+            LOG_ERROR("ERROR::MESH_STREAMER::UPLOAD: Failed to page in chunk " << result.chunk);
+            cpuBytes -= chunk.bytes;
+            chunk.failed = true;
+            continue;
+        }
+
+        chunk.mesh = std::make_unique<Mesh>(std::move(result.data.vertices), std::move(result.data.indices),
+                                            chunk.textures, result.data.localMinBounds, result.data.localMaxBounds,
+                                            format, std::move(result.data.lods),
+                                            std::move(result.data.meshlets), std::move(result.data.instances));
+        // The chunk can be paged in again, only the GPU buffers stay resident
+        chunk.mesh->releaseCpuData();
+        cpuBytes -= chunk.bytes;
+        // Version 0 is behind any built graph, so the first draw pulls the current transforms
+        chunk.mesh->setInstanceNodes(std::move(result.data.instanceNodes), 0);
+        chunk.triangles = chunk.mesh->getLod(0).indexCount / 3 * chunk.mesh->getInstanceCount();
+        gpuBytes += chunk.mesh->getVertexBytes() + chunk.mesh->getIndexBytes() + chunk.mesh->getInstanceBytes();
+        spent += chunk.bytes;
+        residentCount++;
+        triangleCount += chunk.triangles;
+    }
+}
+
+bool MeshStreamer::evictOne() {
+    Chunk* victim = nullptr;
+    for (Chunk& chunk : chunks) {
+        if (chunk.mesh && chunk.lastVisibleFrame < frame &&
+            (victim == nullptr || chunk.lastVisibleFrame < victim->lastVisibleFrame)) {
+            victim = &chunk;
+        }
+    }
+    if (victim == nullptr) {
+        return false;
+    }
+    gpuBytes -= victim->mesh->getVertexBytes() + victim->mesh->getIndexBytes() + victim->mesh->getInstanceBytes();
+    triangleCount -= victim->triangles;
+    residentCount--;
+    victim->mesh.reset();
+    return true;
+}
@@ -0,0 +1,102 @@
+#include "meshlet.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+void finishMeshlet(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                   Meshlet& meshlet) {
+    const unsigned int* begin = &indices[meshlet.indexOffset];
+    const unsigned int* end = begin + meshlet.indexCount;
+
+    glm::vec3 minBounds(std::numeric_limits<float>::max());
+    glm::vec3 maxBounds(std::numeric_limits<float>::lowest());
+    for (const unsigned int* index = begin; index != end; index++) {
+        minBounds = glm::min(minBounds, vertices[*index].Position);
+        maxBounds = glm::max(maxBounds, vertices[*index].Position);
+    }
+    meshlet.center = (minBounds + maxBounds) * 0.5f;
+    meshlet.radius = 0.0f;
+    for (const unsigned int* index = begin; index != end; index++) {
+        meshlet.radius = std::max(meshlet.radius, glm::length(vertices[*index].Position - meshlet.center));
+    }
+
+    // Normal cone: average facing plus the widest deviation from it
+    glm::vec3 axis(0.0f);
+    for (const unsigned int* tri = begin; tri != end; tri += 3) {
+        glm::vec3 normal = glm::cross(vertices[tri[1]].Position - vertices[tri[0]].Position,
+                                      vertices[tri[2]].Position - vertices[tri[0]].Position);
+        float length = glm::length(normal);
+        if (length > 0.0f) {
+            axis += normal / length;
+        }
+    }
+    float axisLength = glm::length(axis);
+    meshlet.coneAxis = axisLength > 0.0f ? axis / axisLength : glm::vec3(0.0f, 0.0f, 1.0f);
+    float minDot = axisLength > 0.0f ? 1.0f : -1.0f;
+    for (const unsigned int* tri = begin; tri != end && minDot > 0.0f; tri += 3) {
+        glm::vec3 normal = glm::cross(vertices[tri[1]].Position - vertices[tri[0]].Position,
+                                      vertices[tri[2]].Position - vertices[tri[0]].Position);
+        float length = glm::length(normal);
+        if (length > 0.0f) {
+            minDot = std::min(minDot, glm::dot(normal / length, meshlet.coneAxis));
+        }
+    }
+    // A cone wider than ~84 degrees can't be culled usefully; cutoff 1 never culls
+    meshlet.coneCutoff = minDot <= 0.1f ? 1.0f : std::sqrt(1.0f - minDot * minDot);
+}
+
+} // namespace
+
+std::vector<Meshlet> buildMeshlets(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices,
+                                   const std::vector<MeshLod>& lods) {
+    std::vector<Meshlet> meshlets;
+    // Stamp of the meshlet that last used each vertex, avoids clearing a set per meshlet
+    std::vector<unsigned int> stamp(vertices.size(), 0);
+    unsigned int currentStamp = 0;
+
+    for (const MeshLod& lod : lods) {
+        Meshlet meshlet;
+        unsigned int meshletVertices = 0;
+        meshlet.indexOffset = lod.indexOffset;
+        currentStamp++;
+
+        for (unsigned int i = lod.indexOffset; i + 3 <= lod.indexOffset + lod.indexCount; i += 3) {
+            unsigned int newVertices = 0;
+            for (int k = 0; k < 3; k++) {
+                newVertices += stamp[indices[i + k]] != currentStamp;
+            }
+            if (meshletVertices + newVertices > MESHLET_MAX_VERTICES ||
+                meshlet.indexCount / 3 >= MESHLET_MAX_TRIANGLES) {
+                finishMeshlet(vertices, indices, meshlet);
+                meshlets.push_back(meshlet);
+                meshlet = Meshlet();
+                meshlet.indexOffset = i;
+                meshletVertices = 0;
+                currentStamp++;
+            }
+            for (int k = 0; k < 3; k++) {
+                if (stamp[indices[i + k]] != currentStamp) {
+                    stamp[indices[i + k]] = currentStamp;
+                    meshletVertices++;
+                }
+            }
+            meshlet.indexCount += 3;
+        }
+        if (meshlet.indexCount > 0) {
+            finishMeshlet(vertices, indices, meshlet);
+            meshlets.push_back(meshlet);
+        }
+    }
+    return meshlets;
+}
+
+bool isMeshletVisible(const Meshlet& meshlet, const MeshletCullContext& context) {
+    if (!context.insideFrustum && !context.frustum.intersectsSphere(meshlet.center, meshlet.radius)) {
+        return false;
+    }
+    // Every triangle faces away when the camera lies inside the cone's back side
+    glm::vec3 toCenter = meshlet.center - context.cameraPosition;
+    return glm::dot(toCenter, meshlet.coneAxis) < meshlet.coneCutoff * glm::length(toCenter) + meshlet.radius;
+}
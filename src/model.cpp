@@ -1,104 +1,645 @@
 #include "model.h"
+#include "hash.h"
+#include "log.h"
+#include "memory_usage.h"
+#include "mesh_cache.h"
+#include "mesh_simplify.h"
+#include "meshlet.h"
+#include "texture_cache.h"
+#include "texture_path_index.h"
+#include "thread_pool.h"
+#include "vertex_convert.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include <stb/stb_image.h>
-#include <iostream>
+#include <assimp/ProgressHandler.hpp>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <sstream>
 
-Model::Model(const char* path) {
+namespace fs = std::filesystem;
+
+namespace {
+
+// Forwards Assimp's read/post-process progress and aborts the import on cancel
+class ImportProgressHandler : public Assimp::ProgressHandler {
+public:
+    explicit ImportProgressHandler(LoadProgress* progress) : progress(progress) {}
+
+    bool Update(float percentage) override {
+        if (percentage >= 0.0f) {
+            progress->fraction = percentage * 0.7f;
+        }
+        return !progress->cancelRequested;
+    }
+
+private:
+    LoadProgress* progress;
+};
+
+// Assimp matrices are row-major
+glm::mat4 toMat4(const aiMatrix4x4& m) {
+    return glm::mat4(m.a1, m.b1, m.c1, m.d1,
+                     m.a2, m.b2, m.c2, m.d2,
+                     m.a3, m.b3, m.c3, m.d3,
+                     m.a4, m.b4, m.c4, m.d4);
+}
+
+// Grows outMin/outMax by the box min/max after transform
+void growTransformedBounds(const glm::mat4& transform, const glm::vec3& min, const glm::vec3& max,
+                           glm::vec3& outMin, glm::vec3& outMax) {
+    for (int corner = 0; corner < 8; corner++) {
+        glm::vec3 point((corner & 1) ? max.x : min.x, (corner & 2) ? max.y : min.y, (corner & 4) ? max.z : min.z);
+        glm::vec3 transformed = glm::vec3(transform * glm::vec4(point, 1.0f));
+        outMin = glm::min(outMin, transformed);
+        outMax = glm::max(outMax, transformed);
+    }
+}
+
+} // namespace
+
+Model::Model(const char* path, const ModelLoadOptions& options) : options(options) {
     if (!path) {
-        std::cerr << "ERROR::MODEL::CONSTRUCTOR: Null path provided" << std::endl;
+        LOG_ERROR("ERROR::MODEL::CONSTRUCTOR: Null path provided");
         m_isValid = false;
         return;
     }
     m_isValid = loadModel(path);
+    if (m_isValid && options.hashMeshes) {
+        computeMeshHashes();
+    }
+    if (m_isValid && options.leanMemory) {
+        releaseImportData();
+    }
+    if (m_isValid && !options.deferUpload) {
+        upload();
+        if (textureCache) {
+            TextureStreamer& textures = textureCache->getStreamer();
+            textures.finish();
+            LOG_INFO("Texture cache: " << textures.getCacheHits() << " hits, " << textures.getCacheMisses()
+                     << " misses, " << textures.getCacheBytesRead() / (1024.0 * 1024.0) << " MB read");
+        }
+        finishLoadReport();
+    }
 }
 
 Model::~Model() {
-    // No need to clean up textures anymore since we're using material colors
+    // textureCache deletes every texture the meshes still reference
+}
+
+void Model::streamTextures(size_t byteBudget) {
+    if (textureCache) {
+        textureCache->getStreamer().pump(byteBudget);
+    }
+    if (m_isValid && isUploaded() && getPendingTextureCount() == 0) {
+        finishLoadReport();
+    }
+}
+
+void Model::releaseImportData() {
+    // Imported meshes carry everything upload() needs, Assimp only held the source
+    importer.reset();
+    scene = nullptr;
+    materialCache.clear();
+}
+
+void Model::computeMeshHashes() {
+    // Runs with the import, off the GL thread, so a reload only pays for the diff
+    ScopedTimer timer(&loadReport, "Mesh hashes", "meshes");
+    meshHashes.clear();
+    for (const auto& data : pendingMeshes) {
+        uint64_t hash = hashWords(data.vertices.data(), data.vertices.size() * sizeof(Vertex));
+        hash = hashWords(data.indices.data(), data.indices.size() * sizeof(unsigned int), hash);
+        hash = hashWords(data.lods.data(), data.lods.size() * sizeof(MeshLod), hash);
+        hash = hashWords(data.meshlets.data(), data.meshlets.size() * sizeof(Meshlet), hash);
+        hash = hashWords(data.instances.data(), data.instances.size() * sizeof(glm::mat4), hash);
+        hash = hashWords(data.instanceNodes.data(), data.instanceNodes.size() * sizeof(uint32_t), hash);
+        for (const auto& texture : data.textures) {
+            hash = fnv1a(texture.type.data(), texture.type.size(), hash);
+            hash = fnv1a(texture.path.data(), texture.path.size(), hash);
+            hash = fnv1a(&texture.diffuseColor, sizeof(texture.diffuseColor), hash);
+            hash = fnv1a(&texture.specularColor, sizeof(texture.specularColor), hash);
+            hash = fnv1a(&texture.shininess, sizeof(texture.shininess), hash);
+        }
+        meshHashes.push_back(hash);
+        timer.addBytes(data.vertices.size() * sizeof(Vertex) + data.indices.size() * sizeof(unsigned int));
+    }
+    timer.addItems(meshHashes.size());
+}
+
+bool Model::replaceChangedMeshes(Model& fresh) {
+    if (streamer || fresh.streamer || !isUploaded() || fresh.nextUpload != 0 ||
+        meshHashes.size() != meshes.size() || fresh.meshHashes.size() != meshes.size() ||
+        fresh.pendingMeshes.size() != meshes.size() || fresh.options.vertexFormat != options.vertexFormat) {
+        return false;
+    }
+
+    // Paths the fresh import resolved take over, new materials may reference new images
+    for (const auto& file : fresh.textureFiles) {
+        textureFiles[file.first] = file.second;
+    }
+    size_t replaced = 0;
+    size_t replacedBytes = 0;
+    for (size_t i = 0; i < meshes.size(); i++) {
+        if (fresh.meshHashes[i] == meshHashes[i]) {
+            continue;
+        }
+        MeshData& data = fresh.pendingMeshes[i];
+        // Acquire before releasing so images both versions use are never re-decoded
+        for (auto& texture : data.textures) {
+            if (!texture.path.empty() && texture.id == 0) {
+                texture.id = TextureFromFile(texture.path.c_str());
+            }
+        }
+        for (const auto& texture : meshes[i].textures) {
+            if (texture.id != 0 && textureCache) {
+                textureCache->release(texture.id);
+            }
+        }
+        replacedBytes += data.vertices.size() * sizeof(Vertex) + data.indices.size() * sizeof(unsigned int);
+        meshes[i].replace(std::move(data.vertices), std::move(data.indices), std::move(data.textures),
+                          data.localMinBounds, data.localMaxBounds, std::move(data.lods), std::move(data.meshlets),
+                          std::move(data.instances));
+        meshes[i].setInstanceNodes(std::move(data.instanceNodes), 0);
+        if (options.leanMemory) {
+            meshes[i].releaseCpuData();
+        }
+        meshHashes[i] = fresh.meshHashes[i];
+        replaced++;
+    }
+    fresh.pendingMeshes.clear();
+    // The fresh hierarchy takes over with the current explode offsets, meshes
+    // re-read every node since their versions followed the old graph
+    sceneGraph = std::move(fresh.sceneGraph);
+    sceneGraph.update();
+    for (size_t i = 0; i < meshes.size(); i++) {
+        meshes[i].refreshInstances(sceneGraph, true);
+        updateMeshBounds(i);
+    }
+    explodeParts.clear();
+    setExplodeAmount(explodeAmount);
+    minBounds = fresh.minBounds;
+    maxBounds = fresh.maxBounds;
+    cacheStatsBefore = fresh.cacheStatsBefore;
+    cacheStatsAfter = fresh.cacheStatsAfter;
+    LOG_INFO("Hot reload: replaced " << replaced << " of " << meshes.size() << " meshes ("
+             << replacedBytes / (1024.0 * 1024.0) << " MB uploaded)");
+    return true;
+}
+
+bool Model::reloadTexture(const std::string& file) {
+    if (!textureCache || !textureCache->reload(file)) {
+        return false;
+    }
+    LOG_INFO("Hot reload: re-decoding texture " << file);
+    return true;
+}
+
+void Model::finishLoadReport() {
+    if (loadReport.isFinished()) {
+        return;
+    }
+    loadReport.finish();
+    if (logEnabled(LogLevel::Info)) {
+        // Through the log so the report stays in order with the lines around it
+        std::ostringstream report;
+        loadReport.print(report);
+        std::string text = report.str();
+        if (!text.empty() && text.back() == '\n') {
+            text.pop_back();
+        }
+        LOG_INFO(text);
+    }
+    LOG_INFO("Resident memory: " << getResidentBytes() / (1024.0 * 1024.0) << " MB (peak "
+             << getPeakResidentBytes() / (1024.0 * 1024.0) << " MB)");
+    if (!options.reportDirectory.empty()) {
+        std::string path = loadReport.write(options.reportDirectory, directory + "/" + filename, fromCache);
+        if (!path.empty()) {
+            LOG_INFO("Load report written to " << path);
+        }
+    }
+}
+
+size_t Model::getVertexBytes() const {
+    size_t bytes = 0;
+    for (const auto& mesh : meshes) {
+        bytes += mesh.getVertexBytes();
+    }
+    return bytes;
+}
+
+size_t Model::getFullVertexBytes() const {
+    size_t bytes = 0;
+    for (const auto& mesh : meshes) {
+        bytes += mesh.getFullVertexBytes();
+    }
+    return bytes;
+}
+
+size_t Model::getIndexBytes() const {
+    size_t bytes = 0;
+    for (const auto& mesh : meshes) {
+        bytes += mesh.getIndexBytes();
+    }
+    return bytes;
+}
+
+size_t Model::getIndexBytesSaved() const {
+    size_t bytes = 0;
+    for (const auto& mesh : meshes) {
+        bytes += mesh.getIndexBytesSaved();
+    }
+    return bytes;
+}
+
+size_t Model::getInstanceCount() const {
+    size_t instances = 0;
+    for (const auto& mesh : meshes) {
+        instances += mesh.getInstanceCount();
+    }
+    return instances;
+}
+
+size_t Model::getInstanceBytes() const {
+    size_t bytes = 0;
+    for (const auto& mesh : meshes) {
+        bytes += mesh.getInstanceBytes();
+    }
+    return bytes;
+}
+
+size_t Model::getFlattenedGeometryBytes() const {
+    size_t bytes = 0;
+    for (const auto& mesh : meshes) {
+        bytes += (mesh.getVertexBytes() + mesh.getIndexBytes()) * mesh.getInstanceCount();
+    }
+    return bytes;
+}
+
+size_t Model::getTriangleCount() const {
+    // Out of core only resident chunks are known
+    size_t triangles = streamer ? streamer->getTriangleCount() : 0;
+    for (const auto& mesh : meshes) {
+        triangles += mesh.getLod(0).indexCount / 3 * mesh.getInstanceCount();
+    }
+    // Imported meshes still waiting for upload() (all of them with deferred upload)
+    for (size_t i = nextUpload; i < pendingMeshes.size(); i++) {
+        const MeshData& data = pendingMeshes[i];
+        triangles += (data.lods.empty() ? data.indices.size() : data.lods[0].indexCount) / 3 *
+                     std::max<size_t>(data.instances.size(), 1);
+    }
+    return triangles;
+}
+
+size_t Model::getPendingTextureCount() const {
+    return textureCache ? textureCache->getStreamer().pendingCount() : 0;
+}
+
+size_t Model::getTextureBytes() const {
+    return textureCache ? textureCache->getStreamer().getTextureBytes() : 0;
+}
+
+const TextureStreamer* Model::getTextureStreamer() const {
+    return textureCache ? &textureCache->getStreamer() : nullptr;
 }
 
-void Model::Draw(Shader &shader) {
-    if (!m_isValid || meshes.empty()) {
+std::vector<std::string> Model::getTextureFiles() const {
+    std::vector<std::string> files;
+    for (const auto& entry : textureFiles) {
+        if (!entry.second.empty()) {
+            files.push_back(entry.second);
+        }
+    }
+    // Several material paths may resolve to one file
+    std::sort(files.begin(), files.end());
+    files.erase(std::unique(files.begin(), files.end()), files.end());
+    return files;
+}
+
+TextureStreamSettings Model::getTextureSettings() const {
+    TextureStreamSettings settings;
+    settings.compress = options.compressTextures;
+    settings.quality = options.compressionQuality;
+    if (options.cacheTextures) {
+        settings.cacheDirectory = directory + "/texture_cache";
+    }
+    return settings;
+}
+
+void Model::Draw(Shader &shader, const DrawView* view) {
+    drawnTriangles = 0;
+    culledTriangles = 0;
+    drawCalls = 0;
+    culledMeshes = 0;
+    if (!m_isValid || (meshes.empty() && !streamer)) {
         return;
     }
 
+    // Meshlet and chunk bounds are in model space, so bring the camera there once per frame
+    MeshletCullContext cull;
+    bool culling = view != nullptr && view->cullMeshlets;
+    if (view != nullptr) {
+        cull.frustum = Frustum::fromMatrix(view->viewProjection * view->model);
+        cull.cameraPosition = glm::vec3(glm::inverse(view->model) * glm::vec4(view->cameraPosition, 1.0f));
+    }
+
+    // Nodes moved since the last frame reach the instance buffers before anything is drawn
+    if (sceneGraph.getNodeCount() > 0 && sceneGraph.update() > 0) {
+        for (size_t i = 0; i < meshes.size(); i++) {
+            if (meshes[i].refreshInstances(sceneGraph)) {
+                updateMeshBounds(i);
+            }
+        }
+    }
+
     // We always have material colors
     shader.setBool("hasTexture", true);
-    for (auto& mesh : meshes) {
-        mesh.Draw(shader);
+    if (streamer) {
+        if (view != nullptr) {
+            streamer->update(cull.frustum, cull.cameraPosition, options.streamingBudget.uploadBytesPerFrame);
+        }
+        for (size_t i = 0; i < streamer->getChunkCount(); i++) {
+            Mesh* mesh = streamer->getVisibleMesh(i);
+            if (mesh == nullptr) {
+                continue;
+            }
+            // Chunks paged in after a move are still at their cached transforms
+            mesh->refreshInstances(sceneGraph);
+            drawMesh(*mesh, shader, view, culling ? &cull : nullptr);
+        }
+        return;
+    }
+
+    // One pass over every mesh box, then only the visible meshes are drawn.
+    // Meshlets of meshes entirely in view skip the frustum test but keep back-face culling.
+    const bool cullingMeshes = view != nullptr && view->cullMeshes;
+    if (cullingMeshes) {
+        auto start = std::chrono::steady_clock::now();
+        meshVisibility.resize(meshBounds.paddedSize());
+        cullBounds(cull.frustum, meshBounds, meshVisibility.data());
+        cullMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+    MeshletCullContext insideCull = cull;
+    insideCull.insideFrustum = true;
+    for (size_t i = 0; i < meshes.size(); i++) {
+        const uint8_t visibility = cullingMeshes ? meshVisibility[i] : static_cast<uint8_t>(CULL_INTERSECTING);
+        if (visibility == CULL_OUTSIDE) {
+            culledMeshes++;
+            continue;
+        }
+        const MeshletCullContext* meshCull = visibility == CULL_INSIDE ? &insideCull : &cull;
+        drawMesh(meshes[i], shader, view, culling ? meshCull : nullptr);
     }
 }
 
+void Model::updateMeshBounds(size_t i) {
+    const Mesh& mesh = meshes[i];
+    if (!mesh.isInstanced()) {
+        meshBounds.set(i, mesh.getBoundsCenter(), mesh.getBoundsExtent());
+        return;
+    }
+    // Each instance's box in model space, its extent projected through the absolute rotation and scale
+    glm::vec3 boxMin(std::numeric_limits<float>::max());
+    glm::vec3 boxMax(std::numeric_limits<float>::lowest());
+    for (size_t instance = 0; instance < mesh.getInstanceCount(); instance++) {
+        const glm::mat4& transform = mesh.getInstanceTransform(instance);
+        const glm::vec3 center = glm::vec3(transform * glm::vec4(mesh.getBoundsCenter(), 1.0f));
+        glm::vec3 extent(0.0f);
+        for (int column = 0; column < 3; column++) {
+            extent += glm::abs(glm::vec3(transform[column])) * mesh.getBoundsExtent()[column];
+        }
+        boxMin = glm::min(boxMin, center - extent);
+        boxMax = glm::max(boxMax, center + extent);
+    }
+    meshBounds.set(i, (boxMin + boxMax) * 0.5f, (boxMax - boxMin) * 0.5f);
+}
+
+void Model::drawMesh(Mesh& mesh, Shader& shader, const DrawView* view, const MeshletCullContext* cull) {
+    size_t lod = view ? mesh.selectLod(*view) : 0;
+    // Meshlet bounds are in mesh space, a single instance gets the camera moved into its own
+    MeshletCullContext instanceCull;
+    if (cull != nullptr && mesh.isInstanced()) {
+        if (mesh.getInstanceCount() == 1) {
+            instanceCull.frustum = Frustum::fromMatrix(view->viewProjection * view->model * mesh.getInstanceTransform(0));
+            instanceCull.cameraPosition = glm::vec3(mesh.getInverseInstanceTransform() * glm::vec4(cull->cameraPosition, 1.0f));
+            instanceCull.insideFrustum = cull->insideFrustum;
+            cull = &instanceCull;
+        } else {
+            cull = nullptr;
+        }
+    }
+    size_t drawn = mesh.Draw(shader, lod, cull);
+    drawnTriangles += drawn;
+    culledTriangles += mesh.getLod(lod).indexCount / 3 * mesh.getInstanceCount() - drawn;
+    drawCalls++;
+}
+
+void Model::setExplodeAmount(float amount) {
+    explodeAmount = amount;
+    if (streamer || !isUploaded() || sceneGraph.getNodeCount() == 0) {
+        return;
+    }
+    if (explodeParts.empty()) {
+        findExplodeParts();
+    }
+    for (size_t i = 0; i < explodeParts.size(); i++) {
+        // Slide along the direction in the parent's space, so the part keeps its own rotation
+        glm::mat4 local = explodeBase[i];
+        local[3] += glm::vec4(explodeDirections[i] * amount, 0.0f);
+        sceneGraph.setLocalTransform(explodeParts[i], local);
+    }
+}
+
+void Model::findExplodeParts() {
+    // The parts are the children of the first node that branches, usually the assembly's top level
+    const size_t nodeCount = sceneGraph.getNodeCount();
+    std::vector<uint32_t> childCount(nodeCount, 0);
+    for (size_t node = 0; node < nodeCount; node++) {
+        if (sceneGraph.getParent(static_cast<uint32_t>(node)) != SceneGraph::NO_PARENT) {
+            childCount[sceneGraph.getParent(static_cast<uint32_t>(node))]++;
+        }
+    }
+    int32_t branch = SceneGraph::NO_PARENT;
+    for (size_t node = 0; node < nodeCount && branch == SceneGraph::NO_PARENT; node++) {
+        if (childCount[node] > 1) {
+            branch = static_cast<int32_t>(node);
+        }
+    }
+    if (branch == SceneGraph::NO_PARENT) {
+        return;
+    }
+
+    // Topological order lets each node inherit its part from the parent in one pass
+    std::vector<int32_t> partOf(nodeCount, -1);
+    for (size_t node = 0; node < nodeCount; node++) {
+        const int32_t parent = sceneGraph.getParent(static_cast<uint32_t>(node));
+        if (parent == branch) {
+            partOf[node] = static_cast<int32_t>(explodeParts.size());
+            explodeParts.push_back(static_cast<uint32_t>(node));
+        } else if (parent != SceneGraph::NO_PARENT) {
+            partOf[node] = partOf[parent];
+        }
+    }
+
+    // Each part moves away from the model center through the center of its instances
+    std::vector<glm::vec3> centers(explodeParts.size(), glm::vec3(0.0f));
+    std::vector<size_t> counts(explodeParts.size(), 0);
+    for (const auto& mesh : meshes) {
+        for (size_t i = 0; i < mesh.getInstanceNodes().size(); i++) {
+            const int32_t part = partOf[mesh.getInstanceNodes()[i]];
+            if (part >= 0) {
+                centers[part] += glm::vec3(mesh.getInstanceTransform(i) * glm::vec4(mesh.getBoundsCenter(), 1.0f));
+                counts[part]++;
+            }
+        }
+    }
+    const glm::mat3 toBranch = glm::inverse(glm::mat3(sceneGraph.getWorldTransform(static_cast<uint32_t>(branch))));
+    explodeBase.resize(explodeParts.size());
+    explodeDirections.resize(explodeParts.size());
+    for (size_t i = 0; i < explodeParts.size(); i++) {
+        explodeBase[i] = sceneGraph.getLocalTransform(explodeParts[i]);
+        explodeDirections[i] = counts[i] > 0 ? toBranch * (centers[i] / static_cast<float>(counts[i]) - getCenter())
+                                             : glm::vec3(0.0f);
+    }
+}
+
+const char* importProfileName(ImportProfile profile) {
+    switch (profile) {
+        case ImportProfile::FastPreview: return "fast preview";
+        case ImportProfile::Balanced: return "balanced";
+        default: return "full validation";
+    }
+}
+
+unsigned int Model::importFlagsFor(const std::string& path, ImportProfile profile, bool instancing) {
+    // Welding is kept even for previews, indexing and every optimizer depend on it
+    unsigned int importFlags = 
+        aiProcess_Triangulate | 
+        aiProcess_GenNormals | 
+        aiProcess_FlipUVs |
+        aiProcess_JoinIdenticalVertices;
+    // Instancing keeps the hierarchy, the flag difference also separates their cache entries
+    if (!instancing) {
+        importFlags |= aiProcess_PreTransformVertices;
+    }
+    if (profile != ImportProfile::FastPreview) {
+        importFlags |= aiProcess_GenUVCoords | aiProcess_FindInvalidData | aiProcess_OptimizeMeshes;
+    }
+    if (profile == ImportProfile::FullValidation) {
+        importFlags |= aiProcess_ValidateDataStructure | aiProcess_FixInfacingNormals;
+    }
+    
+    // Add FBX-specific processing for files with .fbx extension
+    if (path.substr(path.find_last_of(".") + 1) == "fbx") {
+        importFlags |= aiProcess_ConvertToLeftHanded;  // FBX files often need this
+    }
+    return importFlags;
+}
+
+bool Model::makeCacheKey(const std::string& path, const ModelLoadOptions& options, MeshCacheKey& key) {
+    unsigned int processFlags = (options.optimizeMeshes ? MESH_PROCESS_OPTIMIZE : 0) |
+                                (options.buildMeshlets ? MESH_PROCESS_MESHLETS : 0);
+    if (!MeshCache::makeKey(path, importFlagsFor(path, options.importProfile, options.instancing), processFlags, key)) {
+        return false;
+    }
+    key.importProfile = static_cast<unsigned int>(options.importProfile);
+    key.lodLevels = options.lodLevels;
+    key.lodMaxError = options.lodMaxError;
+    return true;
+}
+
 bool Model::loadModel(std::string path) {
-    std::cout << "Loading model from path: " << path << std::endl;
+    LOG_INFO("Loading model from path: " << path);
     
+    sourcePath = path;
+    importer = std::make_unique<Assimp::Importer>();
     // Store the filename
     size_t last_slash = path.find_last_of("/\\");
     filename = (last_slash == std::string::npos) ? path : path.substr(last_slash + 1);
     
     // Configure Assimp to handle material textures properly
-    importer.SetPropertyInteger(AI_CONFIG_IMPORT_FBX_READ_TEXTURES, 1);
-    importer.SetPropertyBool(AI_CONFIG_IMPORT_FBX_PRESERVE_PIVOTS, false);
-    importer.SetPropertyInteger(AI_CONFIG_PP_PTV_NORMALIZE, 1);
+    importer->SetPropertyInteger(AI_CONFIG_IMPORT_FBX_READ_TEXTURES, 1);
+    importer->SetPropertyBool(AI_CONFIG_IMPORT_FBX_PRESERVE_PIVOTS, false);
+    importer->SetPropertyInteger(AI_CONFIG_PP_PTV_NORMALIZE, 1);
     
     // FBX specific configurations
-    importer.SetPropertyFloat(AI_CONFIG_PP_GSN_MAX_SMOOTHING_ANGLE, 80.0f);
-    importer.SetPropertyInteger(AI_CONFIG_IMPORT_FBX_READ_MATERIALS, 1);
-    importer.SetPropertyBool(AI_CONFIG_IMPORT_FBX_READ_TEXTURES, true);
+    importer->SetPropertyFloat(AI_CONFIG_PP_GSN_MAX_SMOOTHING_ANGLE, 80.0f);
+    importer->SetPropertyInteger(AI_CONFIG_IMPORT_FBX_READ_MATERIALS, 1);
+    importer->SetPropertyBool(AI_CONFIG_IMPORT_FBX_READ_TEXTURES, true);
     
-    // Now load with full processing
-    unsigned int importFlags = 
-        aiProcess_Triangulate | 
-        aiProcess_GenNormals | 
-        aiProcess_FlipUVs |
-        aiProcess_CalcTangentSpace |
-        aiProcess_PreTransformVertices |
-        aiProcess_GenUVCoords |
-        aiProcess_JoinIdenticalVertices |
-        aiProcess_ValidateDataStructure |
-        aiProcess_FindInvalidData |
-        aiProcess_FixInfacingNormals |
-        aiProcess_OptimizeMeshes;
+    unsigned int importFlags = importFlagsFor(path, options.importProfile, options.instancing);
     
-    // Add FBX-specific processing for files with .fbx extension
-    if (path.substr(path.find_last_of(".") + 1) == "fbx") {
-        importFlags |= aiProcess_ConvertToLeftHanded;  // FBX files often need this
+    directory = path.substr(0, path.find_last_of("/\\"));
+
+    // A cache hit skips Assimp entirely
+    MeshCache meshCache(options.meshCacheDirectory);
+    MeshCacheKey cacheKey;
+    bool cacheable = options.useMeshCache && makeCacheKey(path, options, cacheKey);
+    if (cacheable && options.outOfCore && openStreamer(meshCache, cacheKey)) {
+        return true;
+    }
+    if (cacheable && loadFromCache(meshCache, cacheKey)) {
+        return true;
     }
     
-    scene = importer.ReadFile(path, importFlags);
-    
+    // Lives past ReadFile and ApplyPostProcessing; resetting the handler to
+    // null below hands it back without the importer deleting it
+    ImportProgressHandler progressHandler(options.progress);
+    if (options.progress) {
+        importer->SetProgressHandler(&progressHandler);
+    }
+    reportProgress("Reading file", 0.0f);
+    {
+        // Read and post-process separately so the report can tell them apart
+        ScopedTimer timer(&loadReport, "Read file");
+        timer.addBytes(cacheable ? cacheKey.sourceSize : 0);
+        scene = importer->ReadFile(path, 0);
+    }
+    if (scene && !cancelled()) {
+        ScopedTimer timer(&loadReport, "Post-process", "meshes");
+        scene = importer->ApplyPostProcessing(importFlags);
+        timer.addItems(scene ? scene->mNumMeshes : 0);
+    }
+    if (options.progress) {
+        importer->SetProgressHandler(nullptr);
+    }
+
+    if (cancelled()) {
+        LOG_INFO("Model load cancelled");
+        return false;
+    }
     if(!scene || scene->mFlags & AI_SCENE_FLAGS_INCOMPLETE || !scene->mRootNode) {
-        std::cerr << "ERROR::ASSIMP::" << importer.GetErrorString() << std::endl;
+        LOG_ERROR("ERROR::ASSIMP::" << importer->GetErrorString());
         return false;
     }
     
-    directory = path.substr(0, path.find_last_of("/\\"));
-    std::cout << "\nModel directory: " << directory << std::endl;
-    std::cout << "Number of materials: " << scene->mNumMaterials << std::endl;
+    LOG_DEBUG("Model directory: " << directory);
+    LOG_DEBUG("Number of materials: " << scene->mNumMaterials);
     
-    // Print detailed material info
-    for (unsigned int i = 0; i < scene->mNumMaterials; i++) {
+    // Print detailed material info, skipping the material queries unless someone reads it
+    for (unsigned int i = 0; logEnabled(LogLevel::Debug) && i < scene->mNumMaterials; i++) {
         aiMaterial* material = scene->mMaterials[i];
         aiString name;
         material->Get(AI_MATKEY_NAME, name);
-        std::cout << "\nMaterial " << i << ":" << std::endl;
-        std::cout << "Name: " << name.C_Str() << std::endl;
+        LOG_DEBUG("Material " << i << ":");
+        LOG_DEBUG("Name: " << name.C_Str());
         
         // Check for textures first
         aiString texPath;
         if(AI_SUCCESS == material->GetTexture(aiTextureType_DIFFUSE, 0, &texPath)) {
-            std::cout << "Diffuse texture path: " << texPath.C_Str() << std::endl;
+            LOG_DEBUG("Diffuse texture path: " << texPath.C_Str());
         }
         
         // Then check material colors
         aiColor4D diffuse(1.0f);
         if(AI_SUCCESS == material->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse)) {
-            std::cout << "Diffuse color: " << diffuse.r << ", " << diffuse.g << ", " << diffuse.b << std::endl;
+            LOG_DEBUG("Diffuse color: " << diffuse.r << ", " << diffuse.g << ", " << diffuse.b);
         }
         
         // Check for FBX specific properties
         aiColor4D baseColor(1.0f);
         if(AI_SUCCESS == material->Get(AI_MATKEY_BASE_COLOR, baseColor)) {
-            std::cout << "Base color: " << baseColor.r << ", " << baseColor.g << ", " << baseColor.b << std::endl;
+            LOG_DEBUG("Base color: " << baseColor.r << ", " << baseColor.g << ", " << baseColor.b);
             // Use base color if diffuse wasn't set
             if (diffuse.r == 1.0f && diffuse.g == 1.0f && diffuse.b == 1.0f) {
                 diffuse = baseColor;
@@ -109,153 +650,505 @@ bool Model::loadModel(std::string path) {
     try {
         processNode(scene->mRootNode, scene);
     } catch (const std::exception& e) {
-        std::cerr << "ERROR::MODEL::LOADING: Exception while processing model: " << e.what() << std::endl;
+        LOG_ERROR("ERROR::MODEL::LOADING: Exception while processing model: " << e.what());
+        return false;
+    }
+
+    if (cancelled()) {
+        LOG_INFO("Model load cancelled");
+        return false;
+    }
+
+    if (pendingMeshes.empty()) {
+        LOG_ERROR("ERROR::MODEL::LOADING: No meshes were loaded from the model");
         return false;
     }
 
-    if (meshes.empty()) {
-        std::cerr << "ERROR::MODEL::LOADING: No meshes were loaded from the model" << std::endl;
+    LOG_INFO("Model imported successfully with " << pendingMeshes.size() << " meshes");
+
+    if (cacheable) {
+        ScopedTimer timer(&loadReport, "Mesh cache write", "meshes");
+        for (const auto& data : pendingMeshes) {
+            timer.addBytes(data.vertices.size() * sizeof(Vertex) + data.indices.size() * sizeof(unsigned int));
+        }
+        timer.addItems(pendingMeshes.size());
+        const bool stored = meshCache.store(cacheKey, pendingMeshes, minBounds, maxBounds, sceneGraph);
+        // Stream from the entry just written and drop the imported copy
+        if (options.outOfCore && stored && openStreamer(meshCache, cacheKey)) {
+            pendingMeshes.clear();
+            pendingMeshes.shrink_to_fit();
+            importer->FreeScene();
+            this->scene = nullptr;
+            return true;
+        }
+        if (options.outOfCore) {
+            LOG_WARNING("No usable mesh cache entry to stream from, keeping " << filename << " in memory");
+        }
+    }
+    resolveTextureFiles();
+    return true;
+}
+
+bool Model::openStreamer(const MeshCache& meshCache, const MeshCacheKey& key) {
+    ScopedTimer timer(&loadReport, "Mesh cache open", "meshes");
+    MeshCacheEntry entry;
+    if (!meshCache.open(key, entry) || entry.getMeshCount() == 0) {
         return false;
     }
 
-    std::cout << "Model loaded successfully with " << meshes.size() << " meshes" << std::endl;
+    LOG_INFO("Streaming model out of core from: " << meshCache.entryPath(key));
+    timer.addItems(entry.getMeshCount());
+    minBounds = entry.getMinBounds();
+    maxBounds = entry.getMaxBounds();
+    entry.readNodes(sceneGraph);
+    streamer = std::make_unique<MeshStreamer>(std::move(entry), options.vertexFormat, options.streamingBudget);
+    fromCache = true;
+    resolveTextureFiles();
     return true;
 }
 
+void Model::setStreamingBudget(const StreamingBudget& budget) {
+    options.streamingBudget = budget;
+    if (streamer) {
+        streamer->setBudget(budget);
+    }
+}
+
+bool Model::loadFromCache(const MeshCache& meshCache, const MeshCacheKey& key) {
+    ScopedTimer timer(&loadReport, "Mesh cache read", "meshes");
+    std::vector<MeshData> cached;
+    if (!meshCache.load(key, cached, minBounds, maxBounds, sceneGraph) || cached.empty()) {
+        return false;
+    }
+    for (const auto& data : cached) {
+        timer.addBytes(data.vertices.size() * sizeof(Vertex) + data.indices.size() * sizeof(unsigned int));
+    }
+    timer.addItems(cached.size());
+
+    LOG_INFO("Loaded model from mesh cache: " << meshCache.entryPath(key));
+    pendingMeshes = std::move(cached);
+    fromCache = true;
+    resolveTextureFiles();
+    return true;
+}
+
+bool Model::upload(size_t byteBudget) {
+    if (streamer) {
+        // Geometry is paged in by Draw, only the materials need GL textures here
+        for (size_t i = 0; i < streamer->getChunkCount(); i++) {
+            for (auto& texture : streamer->getMaterials(i)) {
+                if (!texture.path.empty() && texture.id == 0) {
+                    texture.id = TextureFromFile(texture.path.c_str());
+                }
+            }
+        }
+        return true;
+    }
+
+    ScopedTimer timer(&loadReport, "Mesh upload", "meshes");
+    size_t uploadedBytes = 0;
+    meshes.reserve(pendingMeshes.size());
+    while (nextUpload < pendingMeshes.size() && uploadedBytes < byteBudget) {
+        MeshData& data = pendingMeshes[nextUpload++];
+        // Texture ids are per-context, so they are only resolved here
+        for (auto& texture : data.textures) {
+            if (!texture.path.empty() && texture.id == 0) {
+                texture.id = TextureFromFile(texture.path.c_str());
+            }
+        }
+        uploadedBytes += data.vertices.size() * sizeof(Vertex) + data.indices.size() * sizeof(unsigned int);
+        meshes.emplace_back(std::move(data.vertices), std::move(data.indices), std::move(data.textures),
+                            data.localMinBounds, data.localMaxBounds, options.vertexFormat, std::move(data.lods), std::move(data.meshlets),
+                            std::move(data.instances));
+        meshes.back().setInstanceNodes(std::move(data.instanceNodes), sceneGraph.getVersion());
+        meshBounds.resize(meshes.size());
+        updateMeshBounds(meshes.size() - 1);
+        if (options.leanMemory) {
+            meshes.back().releaseCpuData();
+        }
+        data = MeshData();  // Moved into the mesh, drop the empty shells
+        reportProgress("Uploading", 0.9f + 0.1f * nextUpload / pendingMeshes.size());
+        timer.addItems(1);
+    }
+    timer.addBytes(uploadedBytes);
+
+    if (nextUpload < pendingMeshes.size()) {
+        return false;
+    }
+    LOG_INFO("Vertex memory: " << getVertexBytes() / (1024.0 * 1024.0) << " MB ("
+             << getFullVertexBytes() / (1024.0 * 1024.0) << " MB uncompressed)");
+    if (getInstanceCount() > meshes.size()) {
+        LOG_INFO("Instancing: " << meshes.size() << " meshes for " << getInstanceCount() << " instances, "
+                 << (getVertexBytes() + getIndexBytes() + getInstanceBytes()) / (1024.0 * 1024.0) << " MB geometry ("
+                 << getFlattenedGeometryBytes() / (1024.0 * 1024.0) << " MB flattened), " << meshes.size()
+                 << " draw calls (" << getInstanceCount() << " flattened)");
+    }
+    pendingMeshes.clear();
+    pendingMeshes.shrink_to_fit();
+    nextUpload = 0;
+    return true;
+}
+
+void Model::reportProgress(const char* stage, float fraction) const {
+    if (options.progress) {
+        options.progress->stage = stage;
+        options.progress->fraction = fraction;
+    }
+}
+
 void Model::processNode(aiNode *node, const aiScene *scene) {
-    // process all the node's meshes (if any)
+    // Gather the meshes in traversal order first so conversion can run out of order
+    std::vector<aiMesh*> sceneMeshes;
+    std::vector<std::vector<glm::mat4>> instances;
+    std::vector<std::vector<uint32_t>> instanceNodes;
+    if (options.instancing) {
+        // Every mesh once, with the scene graph nodes that reference it
+        std::vector<std::vector<uint32_t>> byMesh(scene->mNumMeshes);
+        sceneGraph.clear();
+        collectInstances(node, SceneGraph::NO_PARENT, byMesh);
+        sceneGraph.update();
+        for (unsigned int i = 0; i < scene->mNumMeshes; i++) {
+            if (!byMesh[i].empty()) {
+                sceneMeshes.push_back(scene->mMeshes[i]);
+                std::vector<glm::mat4> transforms;
+                transforms.reserve(byMesh[i].size());
+                for (uint32_t instanceNode : byMesh[i]) {
+                    transforms.push_back(sceneGraph.getWorldTransform(instanceNode));
+                }
+                instances.push_back(std::move(transforms));
+                instanceNodes.push_back(std::move(byMesh[i]));
+            }
+        }
+    } else {
+        collectMeshes(node, scene, sceneMeshes);
+    }
+
+    if (options.benchmarkConversion) {
+        benchmarkConversion(sceneMeshes);
+    }
+
+    unsigned int threads = options.parallelConversion ? options.workerThreads : 1;
+    if (threads == 0) {
+        threads = ThreadPool::hardwareThreads();
+    }
+
+    reportProgress("Converting meshes", 0.7f);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<MeshData> converted;
+    {
+        ScopedTimer timer(&loadReport, "Convert meshes", "meshes");
+        timer.addItems(sceneMeshes.size());
+        converted = convertMeshes(sceneMeshes, threads, &loadReport, instances);
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    LOG_INFO("Converted " << sceneMeshes.size() << " meshes in " << elapsed.count()
+             << " ms using " << threads << " thread(s)");
+    if (hasVertexCacheStats()) {
+        LOG_INFO("Vertex cache: ACMR " << cacheStatsBefore.acmr() << " -> " << cacheStatsAfter.acmr()
+                 << ", ATVR " << cacheStatsBefore.atvr() << " -> " << cacheStatsAfter.atvr());
+    }
+
+    if (cancelled()) {
+        return;
+    }
+
+    // Materials are resolved serially in the original order, GL uploads happen later in upload()
+    reportProgress("Reading materials", 0.9f);
+    ScopedTimer timer(&loadReport, "Materials", "meshes");
+    timer.addItems(converted.size());
+    for (size_t i = 0; i < converted.size(); i++) {
+        if (!instanceNodes.empty()) {
+            converted[i].instanceNodes = std::move(instanceNodes[i]);
+        }
+        minBounds = glm::min(minBounds, converted[i].minBounds);
+        maxBounds = glm::max(maxBounds, converted[i].maxBounds);
+        processMesh(sceneMeshes[i], scene, converted[i]);
+    }
+    pendingMeshes = std::move(converted);
+}
+
+void Model::collectMeshes(aiNode *node, const aiScene *scene, std::vector<aiMesh*>& out) {
+    // collect all the node's meshes (if any)
     for(unsigned int i = 0; i < node->mNumMeshes; i++) {
-        aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-        meshes.push_back(processMesh(mesh, scene));
+        out.push_back(scene->mMeshes[node->mMeshes[i]]);
     }
     // then do the same for each of its children
     for(unsigned int i = 0; i < node->mNumChildren; i++) {
-        processNode(node->mChildren[i], scene);
+        collectMeshes(node->mChildren[i], scene, out);
     }
 }
 
-Mesh Model::processMesh(aiMesh *mesh, const aiScene *scene) {
-    std::cout << "Processing mesh: " << (mesh->mName.length > 0 ? mesh->mName.C_Str() : "unnamed") << std::endl;
-    std::cout << "Has texture coords: " << (mesh->mTextureCoords[0] != nullptr ? "yes" : "no") << std::endl;
-    
-    std::vector<Vertex> vertices = getVertices(mesh);
-    std::vector<unsigned int> indices = getIndices(mesh);
-    std::vector<Texture> textures;
-
-    if(mesh->mMaterialIndex >= 0) {
-        std::cout << "Processing material index: " << mesh->mMaterialIndex << std::endl;
-        aiMaterial* material = scene->mMaterials[mesh->mMaterialIndex];
-        
-        // Get material colors
-        aiColor4D diffuse(1.0f, 1.0f, 1.0f, 1.0f);
-        aiColor4D specular(1.0f, 1.0f, 1.0f, 1.0f);
-        float shininess = 32.0f;
-
-        aiGetMaterialColor(material, AI_MATKEY_COLOR_DIFFUSE, &diffuse);
-        aiGetMaterialColor(material, AI_MATKEY_COLOR_SPECULAR, &specular);
-        aiGetMaterialFloat(material, AI_MATKEY_SHININESS, &shininess);
-
-        std::cout << "Material properties:" << std::endl;
-        std::cout << "Diffuse: " << diffuse.r << ", " << diffuse.g << ", " << diffuse.b << std::endl;
-        std::cout << "Specular: " << specular.r << ", " << specular.g << ", " << specular.b << std::endl;
-        std::cout << "Shininess: " << shininess << std::endl;
-        
-        std::vector<Texture> diffuseMaps = loadMaterialTextures(material, 
-            aiTextureType_DIFFUSE, "texture_diffuse");
-        textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-        
-        std::vector<Texture> specularMaps = loadMaterialTextures(material, 
-            aiTextureType_SPECULAR, "texture_specular");
-        textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
+void Model::collectInstances(aiNode *node, int32_t parent, std::vector<std::vector<uint32_t>>& out) {
+    // Depth first, so every parent is added before its children
+    const uint32_t index = sceneGraph.addNode(parent, toMat4(node->mTransformation));
+    for (unsigned int i = 0; i < node->mNumMeshes; i++) {
+        out[node->mMeshes[i]].push_back(index);
+    }
+    for (unsigned int i = 0; i < node->mNumChildren; i++) {
+        collectInstances(node->mChildren[i], static_cast<int32_t>(index), out);
+    }
+}
 
-        // Store material properties in first texture
-        if (!textures.empty()) {
-            textures[0].diffuseColor = glm::vec3(diffuse.r, diffuse.g, diffuse.b);
+std::vector<MeshData> Model::convertMeshes(const std::vector<aiMesh*>& sceneMeshes, unsigned int threads,
+                                           LoadReport* report, const std::vector<std::vector<glm::mat4>>& instances) {
+    std::vector<MeshData> converted(sceneMeshes.size());
+    std::vector<VertexCacheStats> before(sceneMeshes.size());
+    std::vector<VertexCacheStats> after(sceneMeshes.size());
+    std::atomic<size_t> done(0);
+    auto convert = [&](size_t i) {
+        if (cancelled()) {
+            return;
+        }
+        MeshData& data = converted[i];
+        {
+            // Per-mesh stages run on the workers, the report sums them
+            ScopedTimer timer(report, "Vertex conversion", "vertices");
+            data.vertices = getVertices(sceneMeshes[i], data.localMinBounds, data.localMaxBounds);
+            data.indices = getIndices(sceneMeshes[i]);
+            timer.addBytes(data.vertices.size() * sizeof(Vertex) + data.indices.size() * sizeof(unsigned int));
+            timer.addItems(data.vertices.size());
+        }
+        const size_t triangles = data.indices.size() / 3;
+        // The optimizers assume a pure triangle list
+        if (sceneMeshes[i]->mPrimitiveTypes == aiPrimitiveType_TRIANGLE) {
+            before[i] = analyzeVertexCache(data.indices, data.vertices.size());
+            after[i] = before[i];
+            if (options.optimizeMeshes) {
+                ScopedTimer timer(report, "Optimize", "triangles");
+                timer.addItems(triangles);
+                optimizeVertexCache(data.indices, data.vertices.size());
+                optimizeOverdraw(data.indices, data.vertices);
+                after[i] = analyzeVertexCache(data.indices, data.vertices.size());
+            }
+            if (options.lodLevels > 0) {
+                ScopedTimer timer(report, "LOD generation", "triangles");
+                timer.addItems(triangles);
+                buildLodChain(data.vertices, data.indices, data.lods, options.lodLevels, options.lodMaxError);
+                for (size_t lod = 1; options.optimizeMeshes && lod < data.lods.size(); lod++) {
+                    optimizeVertexCache(data.indices.data() + data.lods[lod].indexOffset, data.lods[lod].indexCount,
+                                        data.vertices.size());
+                }
+            }
+            // Every coarser level only uses a subset of the full level's vertices
+            if (options.optimizeMeshes) {
+                ScopedTimer timer(report, "Optimize", "triangles");
+                optimizeVertexFetch(data.vertices, data.indices);
+            }
+            // Last, meshlets are ranges of the final index order
+            if (options.buildMeshlets) {
+                ScopedTimer timer(report, "Meshlets", "triangles");
+                timer.addItems(triangles);
+                std::vector<MeshLod> levels = data.lods;
+                if (levels.empty()) {
+                    levels.resize(1);
+                    levels[0].indexCount = static_cast<unsigned int>(data.indices.size());
+                }
+                data.meshlets = buildMeshlets(data.vertices, data.indices, levels);
+            }
+        }
+        if (!instances.empty()) {
+            data.instances = instances[i];
+            for (const glm::mat4& transform : data.instances) {
+                growTransformedBounds(transform, data.localMinBounds, data.localMaxBounds,
+                                      data.minBounds, data.maxBounds);
+            }
         } else {
-            // If no textures, create a dummy texture to store the material color
-            Texture colorTexture;
-            colorTexture.id = 0; // No texture
-            colorTexture.type = "texture_diffuse";
-            colorTexture.path = ""; // Empty path since it's just a color
-            colorTexture.diffuseColor = glm::vec3(diffuse.r, diffuse.g, diffuse.b);
-            textures.push_back(colorTexture);
+            data.minBounds = data.localMinBounds;
+            data.maxBounds = data.localMaxBounds;
+        }
+        reportProgress("Converting meshes", 0.7f + 0.2f * (++done) / sceneMeshes.size());
+    };
+
+    if (threads <= 1 || sceneMeshes.size() <= 1) {
+        for (size_t i = 0; i < sceneMeshes.size(); i++) {
+            convert(i);
         }
     } else {
-        std::cout << "Mesh has no material" << std::endl;
+        // Each mesh writes only its own slot, so the output order is deterministic
+        ThreadPool pool(threads);
+        pool.parallelFor(sceneMeshes.size(), convert);
+    }
+
+    cacheStatsBefore = VertexCacheStats();
+    cacheStatsAfter = VertexCacheStats();
+    for (size_t i = 0; i < sceneMeshes.size(); i++) {
+        cacheStatsBefore.triangles += before[i].triangles;
+        cacheStatsBefore.vertices += before[i].vertices;
+        cacheStatsBefore.transformed += before[i].transformed;
+        cacheStatsAfter.triangles += after[i].triangles;
+        cacheStatsAfter.vertices += after[i].vertices;
+        cacheStatsAfter.transformed += after[i].transformed;
+    }
+    return converted;
+}
+
+void Model::benchmarkConversion(const std::vector<aiMesh*>& sceneMeshes) {
+    LOG_INFO("Mesh conversion benchmark (" << sceneMeshes.size() << " meshes):");
+    double baseline = 0.0;
+    unsigned int maxThreads = ThreadPool::hardwareThreads();
+    for (unsigned int threads = 1; ; threads = std::min(threads * 2, maxThreads)) {
+        auto start = std::chrono::steady_clock::now();
+        convertMeshes(sceneMeshes, threads, nullptr);
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        if (threads == 1) {
+            baseline = elapsed.count();
+        }
+        LOG_INFO("  " << threads << " thread(s): " << elapsed.count() << " ms, speedup "
+                 << (elapsed.count() > 0.0 ? baseline / elapsed.count() : 0.0) << "x");
+        if (threads == maxThreads) {
+            break;
+        }
+    }
+
+    // Vertex interleaving alone, single threaded, on every path this CPU supports
+    size_t vertexCount = 0;
+    for (aiMesh* mesh : sceneMeshes) {
+        vertexCount = std::max<size_t>(vertexCount, mesh->mNumVertices);
+    }
+    std::vector<Vertex> scratch(vertexCount);
+    const VertexConvertPath paths[] = { VertexConvertPath::Scalar, VertexConvertPath::SSE2, VertexConvertPath::AVX };
+    for (VertexConvertPath path : paths) {
+        if (path > bestVertexConvertPath()) {
+            break;
+        }
+        size_t converted = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (aiMesh* mesh : sceneMeshes) {
+            glm::vec3 meshMin(std::numeric_limits<float>::max());
+            glm::vec3 meshMax(std::numeric_limits<float>::lowest());
+            convertVertices(getVertexStreams(mesh), mesh->mNumVertices, scratch.data(), meshMin, meshMax, path);
+            converted += mesh->mNumVertices;
+        }
+        std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+        LOG_INFO("  vertex conversion (" << vertexConvertPathName(path) << "): " << elapsed.count() << " ms, "
+                 << (elapsed.count() > 0.0 ? converted / elapsed.count() / 1000.0 : 0.0) << " Mvertices/s");
+    }
+}
+
+void Model::processMesh(aiMesh *mesh, const aiScene *scene, MeshData& data) {
+    LOG_DEBUG("Processing mesh: " << (mesh->mName.length > 0 ? mesh->mName.C_Str() : "unnamed"));
+    LOG_DEBUG("Has texture coords: " << (mesh->mTextureCoords[0] != nullptr ? "yes" : "no"));
+    
+    const std::vector<Vertex>& vertices = data.vertices;
+    const std::vector<unsigned int>& indices = data.indices;
+    std::vector<Texture>& textures = data.textures;
+
+    if(mesh->mMaterialIndex >= 0) {
+        textures = getMaterialTextures(mesh->mMaterialIndex, scene);
+    } else {
+        LOG_DEBUG("Mesh has no material");
         // Create default material
         Texture defaultTexture;
         defaultTexture.id = 0;
         defaultTexture.type = "texture_diffuse";
         defaultTexture.path = "";
         defaultTexture.diffuseColor = glm::vec3(0.8f); // Default gray color
-        textures.push_back(defaultTexture);
+        textures.push_back(std::move(defaultTexture));
     }
     
-    std::cout << "Mesh processed with " << vertices.size() << " vertices, " << indices.size() << " indices, and " << textures.size() << " textures" << std::endl;
-    return Mesh(vertices, indices, textures);
+    LOG_DEBUG("Mesh processed with " << vertices.size() << " vertices, " << indices.size() << " indices, and " << textures.size() << " textures");
 }
 
-void Model::updateBounds(const glm::vec3& point) {
-    minBounds.x = std::min(minBounds.x, point.x);
-    minBounds.y = std::min(minBounds.y, point.y);
-    minBounds.z = std::min(minBounds.z, point.z);
+const std::vector<Texture>& Model::getMaterialTextures(unsigned int materialIndex, const aiScene *scene) {
+    // Materials are shared between meshes, parse each one once per import
+    auto cached = materialCache.find(materialIndex);
+    if (cached != materialCache.end()) {
+        return cached->second;
+    }
+
+    std::vector<Texture>& textures = materialCache[materialIndex];
+    LOG_DEBUG("Processing material index: " << materialIndex);
+    aiMaterial* material = scene->mMaterials[materialIndex];
     
-    maxBounds.x = std::max(maxBounds.x, point.x);
-    maxBounds.y = std::max(maxBounds.y, point.y);
-    maxBounds.z = std::max(maxBounds.z, point.z);
-}
+    // Get material colors
+    aiColor4D diffuse(1.0f, 1.0f, 1.0f, 1.0f);
+    aiColor4D specular(1.0f, 1.0f, 1.0f, 1.0f);
+    float shininess = 32.0f;
+
+    aiGetMaterialColor(material, AI_MATKEY_COLOR_DIFFUSE, &diffuse);
+    aiGetMaterialColor(material, AI_MATKEY_COLOR_SPECULAR, &specular);
+    aiGetMaterialFloat(material, AI_MATKEY_SHININESS, &shininess);
 
-std::vector<Vertex> Model::getVertices(aiMesh *mesh) {
-    std::vector<Vertex> vertices;
+    LOG_DEBUG("Material properties:");
+    LOG_DEBUG("Diffuse: " << diffuse.r << ", " << diffuse.g << ", " << diffuse.b);
+    LOG_DEBUG("Specular: " << specular.r << ", " << specular.g << ", " << specular.b);
+    LOG_DEBUG("Shininess: " << shininess);
     
-    for(unsigned int i = 0; i < mesh->mNumVertices; i++) {
-        Vertex vertex;
-        
-        // Process vertex positions, normals and texture coordinates
-        glm::vec3 vector;
-        vector.x = mesh->mVertices[i].x;
-        vector.y = mesh->mVertices[i].y;
-        vector.z = mesh->mVertices[i].z;
-        vertex.Position = vector;
-        
-        // Update bounding box
-        updateBounds(vector);
-        
-        vector.x = mesh->mNormals[i].x;
-        vector.y = mesh->mNormals[i].y;
-        vector.z = mesh->mNormals[i].z;
-        vertex.Normal = vector;
-        
-        if(mesh->mTextureCoords[0]) {
-            glm::vec2 vec;
-            vec.x = mesh->mTextureCoords[0][i].x;
-            vec.y = mesh->mTextureCoords[0][i].y;
-            vertex.TexCoords = vec;
-        }
-        else
-            vertex.TexCoords = glm::vec2(0.0f, 0.0f);
-        
-        vertices.push_back(vertex);
+    std::vector<Texture> diffuseMaps = loadMaterialTextures(material, 
+        aiTextureType_DIFFUSE, "texture_diffuse");
+    textures.insert(textures.end(), std::make_move_iterator(diffuseMaps.begin()),
+                    std::make_move_iterator(diffuseMaps.end()));
+    
+    std::vector<Texture> specularMaps = loadMaterialTextures(material, 
+        aiTextureType_SPECULAR, "texture_specular");
+    textures.insert(textures.end(), std::make_move_iterator(specularMaps.begin()),
+                    std::make_move_iterator(specularMaps.end()));
+
+    // Store material properties in first texture
+    if (!textures.empty()) {
+        textures[0].diffuseColor = glm::vec3(diffuse.r, diffuse.g, diffuse.b);
+    } else {
+        // If no textures, create a dummy texture to store the material color
+        Texture colorTexture;
+        colorTexture.id = 0; // No texture
+        colorTexture.type = "texture_diffuse";
+        colorTexture.path = ""; // Empty path since it's just a color
+        colorTexture.diffuseColor = glm::vec3(diffuse.r, diffuse.g, diffuse.b);
+        textures.push_back(std::move(colorTexture));
     }
+    return textures;
+}
+
+std::vector<Vertex> Model::getVertices(aiMesh *mesh, glm::vec3& meshMin, glm::vec3& meshMax) {
+    // Presized output, interleaved and bounded in a single vectorized pass
+    std::vector<Vertex> vertices(mesh->mNumVertices);
+    convertVertices(getVertexStreams(mesh), vertices.size(), vertices.data(), meshMin, meshMax);
     return vertices;
 }
 
+VertexStreams Model::getVertexStreams(aiMesh *mesh) {
+    static_assert(sizeof(aiVector3D) == 3 * sizeof(float), "Assimp must be built with single precision");
+    VertexStreams streams;
+    streams.positions = &mesh->mVertices[0].x;
+    streams.normals = mesh->mNormals ? &mesh->mNormals[0].x : nullptr;
+    streams.texCoords = mesh->mTextureCoords[0] ? &mesh->mTextureCoords[0][0].x : nullptr;
+    return streams;
+}
+
 std::vector<unsigned int> Model::getIndices(aiMesh *mesh) {
     std::vector<unsigned int> indices;
+
+    // Triangulated meshes: fixed three indices per face, no per-index growth checks
+    if (mesh->mPrimitiveTypes == aiPrimitiveType_TRIANGLE) {
+        indices.resize(static_cast<size_t>(mesh->mNumFaces) * 3);
+        unsigned int* out = indices.data();
+        for(unsigned int i = 0; i < mesh->mNumFaces; i++) {
+            const unsigned int* face = mesh->mFaces[i].mIndices;
+            out[0] = face[0];
+            out[1] = face[1];
+            out[2] = face[2];
+            out += 3;
+        }
+        return indices;
+    }
+
+    size_t count = 0;
+    for(unsigned int i = 0; i < mesh->mNumFaces; i++)
+        count += mesh->mFaces[i].mNumIndices;
+    indices.reserve(count);
     for(unsigned int i = 0; i < mesh->mNumFaces; i++) {
-        aiFace face = mesh->mFaces[i];
-        for(unsigned int j = 0; j < face.mNumIndices; j++)
-            indices.push_back(face.mIndices[j]);
+        const aiFace& face = mesh->mFaces[i];
+        indices.insert(indices.end(), face.mIndices, face.mIndices + face.mNumIndices);
     }
     return indices;
 }
 
-std::vector<Texture> Model::loadMaterialTextures(aiMaterial *mat, aiTextureType type, std::string typeName) {
+std::vector<Texture> Model::loadMaterialTextures(aiMaterial *mat, aiTextureType type, const std::string& typeName) {
     std::vector<Texture> textures;
     unsigned int numTextures = mat->GetTextureCount(type);
     
-    std::cout << "\nProcessing material textures of type: " << typeName << std::endl;
-    std::cout << "Number of textures found: " << numTextures << std::endl;
+    LOG_DEBUG("Processing material textures of type: " << typeName);
+    LOG_DEBUG("Number of textures found: " << numTextures);
     
     // Get material properties
     aiColor4D diffuse(1.0f);
@@ -264,19 +1157,19 @@ std::vector<Texture> Model::loadMaterialTextures(aiMaterial *mat, aiTextureType
     
     // Try different material properties in order of preference
     if(AI_SUCCESS == mat->Get(AI_MATKEY_BASE_COLOR, diffuse)) {
-        std::cout << "Found BASE_COLOR: " << diffuse.r << ", " << diffuse.g << ", " << diffuse.b << std::endl;
+        LOG_DEBUG("Found BASE_COLOR: " << diffuse.r << ", " << diffuse.g << ", " << diffuse.b);
     } else if(AI_SUCCESS == mat->Get(AI_MATKEY_COLOR_DIFFUSE, diffuse)) {
-        std::cout << "Found COLOR_DIFFUSE: " << diffuse.r << ", " << diffuse.g << ", " << diffuse.b << std::endl;
+        LOG_DEBUG("Found COLOR_DIFFUSE: " << diffuse.r << ", " << diffuse.g << ", " << diffuse.b);
     }
     
     if(AI_SUCCESS == mat->Get(AI_MATKEY_SPECULAR_FACTOR, specular)) {
-        std::cout << "Found SPECULAR_FACTOR: " << specular.r << ", " << specular.g << ", " << specular.b << std::endl;
+        LOG_DEBUG("Found SPECULAR_FACTOR: " << specular.r << ", " << specular.g << ", " << specular.b);
     } else if(AI_SUCCESS == mat->Get(AI_MATKEY_COLOR_SPECULAR, specular)) {
-        std::cout << "Found COLOR_SPECULAR: " << specular.r << ", " << specular.g << ", " << specular.b << std::endl;
+        LOG_DEBUG("Found COLOR_SPECULAR: " << specular.r << ", " << specular.g << ", " << specular.b);
     }
     
     if(AI_SUCCESS == mat->Get(AI_MATKEY_SHININESS, shininess)) {
-        std::cout << "Found SHININESS: " << shininess << std::endl;
+        LOG_DEBUG("Found SHININESS: " << shininess);
     }
     
     // First check for textures
@@ -284,29 +1177,24 @@ std::vector<Texture> Model::loadMaterialTextures(aiMaterial *mat, aiTextureType
         for(unsigned int i = 0; i < numTextures; i++) {
             aiString texPath;
             if (AI_SUCCESS == mat->GetTexture(type, i, &texPath)) {
-                std::cout << "Found texture path: " << texPath.C_Str() << std::endl;
+                LOG_DEBUG("Found texture path: " << texPath.C_Str());
                 
+                // The GL texture is created in upload(), on the context thread
                 Texture texture;
-                texture.id = TextureFromFile(texPath.C_Str(), directory);
+                texture.id = 0;
                 texture.type = typeName;
                 texture.path = texPath.C_Str();
                 texture.diffuseColor = glm::vec3(diffuse.r, diffuse.g, diffuse.b);
                 texture.specularColor = glm::vec3(specular.r, specular.g, specular.b);
                 texture.shininess = shininess;
-                
-                if (texture.id != 0) {
-                    std::cout << "Successfully loaded texture with ID: " << texture.id << std::endl;
-                    textures.push_back(texture);
-                } else {
-                    std::cout << "Failed to load texture, using material color as fallback" << std::endl;
-                }
+                textures.push_back(std::move(texture));
             }
         }
     }
     
     // If no valid textures were loaded, create a color-only texture
     if (textures.empty()) {
-        std::cout << "No valid textures found, creating color-only texture" << std::endl;
+        LOG_DEBUG("No valid textures found, creating color-only texture");
         Texture texture;
         texture.id = 0;
         texture.type = typeName;
@@ -314,94 +1202,109 @@ std::vector<Texture> Model::loadMaterialTextures(aiMaterial *mat, aiTextureType
         texture.diffuseColor = glm::vec3(diffuse.r, diffuse.g, diffuse.b);
         texture.specularColor = glm::vec3(specular.r, specular.g, specular.b);
         texture.shininess = shininess;
-        textures.push_back(texture);
+        textures.push_back(std::move(texture));
     }
     
     return textures;
 }
 
-unsigned int Model::TextureFromFile(const char *path, const std::string &directory) {
-    unsigned int textureID;
-    glGenTextures(1, &textureID);
+void Model::resolveTextureFiles() {
+    // Runs during import, off the GL thread: find every referenced image on disk
+    // once and collapse files with identical contents onto a single entry
+    ScopedTimer timer(&loadReport, "Resolve textures", "files");
+    std::unique_ptr<TexturePathIndex> pathIndex;  // Walks folders only on the first path that misses
+    std::vector<std::string> added;
+    // Canonical file -> size, and the files of each size, for spotting duplicates
+    std::unordered_map<std::string, uint64_t> fileSizes;
+    std::unordered_map<uint64_t, std::vector<std::string>> filesBySize;
+    size_t references = 0;
+    std::vector<const std::vector<Texture>*> materials;
+    for (const auto& data : pendingMeshes) {
+        materials.push_back(&data.textures);
+    }
+    for (size_t i = 0; streamer && i < streamer->getChunkCount(); i++) {
+        materials.push_back(&streamer->getMaterials(i));
+    }
+    for (const auto* textures : materials) {
+        for (const auto& texture : *textures) {
+            if (texture.path.empty()) {
+                continue;
+            }
+            references++;
+            if (textureFiles.count(texture.path)) {
+                continue;
+            }
 
-    std::string filename;
-    std::string pathStr(path);
-    
-    // Handle different path formats
-    if (pathStr.find(":/") != std::string::npos || pathStr.find(":\\") != std::string::npos) {
-        // Absolute path
-        filename = pathStr;
-    } else if (directory.empty()) {
-        filename = pathStr;
-    } else {
-        // Try multiple possible texture locations
-        std::vector<std::string> possiblePaths = {
-            directory + "/" + pathStr,
-            directory + "/Textures/" + pathStr,
-            directory + "/../Textures/" + pathStr,
-            pathStr
-        };
-        
-        bool found = false;
-        for (const auto& testPath : possiblePaths) {
-            FILE* file = fopen(testPath.c_str(), "rb");
-            if (file) {
-                fclose(file);
-                filename = testPath;
-                found = true;
-                std::cout << "Found texture at: " << filename << std::endl;
-                break;
+            if (!pathIndex) {
+                pathIndex = std::make_unique<TexturePathIndex>(directory);
             }
+            std::string filename = pathIndex->resolve(texture.path);
+            std::error_code ec;
+            if (!filename.empty()) {
+                // Different spellings of one path collapse here without touching the contents
+                fs::path canonical = fs::weakly_canonical(filename, ec);
+                if (!ec) {
+                    filename = canonical.generic_string();
+                }
+                if (!fileSizes.count(filename)) {
+                    uint64_t size = fs::file_size(filename, ec);
+                    fileSizes[filename] = ec ? 0 : size;
+                    filesBySize[fileSizes[filename]].push_back(filename);
+                }
+            }
+            textureFiles[texture.path] = filename;
+            added.push_back(texture.path);
         }
-        
-        if (!found) {
-            std::cout << "Failed to find texture in any of these locations:" << std::endl;
-            for (const auto& path : possiblePaths) {
-                std::cout << "  - " << path << std::endl;
+    }
+
+    // Only files whose sizes collide can have the same contents, and only those
+    // are read. Equal hashes are confirmed byte for byte before two files merge.
+    std::unordered_map<std::string, std::string> duplicates;
+    size_t distinctImages = fileSizes.size();
+    for (const auto& group : filesBySize) {
+        if (group.second.size() < 2) {
+            continue;
+        }
+        std::unordered_map<uint64_t, std::vector<std::string>> filesByContent;
+        for (const std::string& filename : group.second) {
+            uint64_t hash;
+            if (!hashFile(filename, hash)) {
+                continue;  // Unreadable, it fails on its own later
+            }
+            std::vector<std::string>& candidates = filesByContent[hash];
+            auto same = std::find_if(candidates.begin(), candidates.end(), [&](const std::string& other) {
+                return sameFileContents(other, filename);
+            });
+            if (same == candidates.end()) {
+                candidates.push_back(filename);
+                continue;
             }
-            return 0;
+            LOG_DEBUG("Texture " << filename << " has the same contents as " << *same << ", sharing it");
+            duplicates[filename] = *same;
+            distinctImages--;
         }
     }
-    
-    std::cout << "Loading texture from: " << filename << std::endl;
+    for (const std::string& path : added) {
+        auto duplicate = duplicates.find(textureFiles[path]);
+        if (duplicate != duplicates.end()) {
+            textureFiles[path] = duplicate->second;
+        }
+    }
+    timer.addItems(textureFiles.size());
+    LOG_INFO("Textures: " << references << " references, " << textureFiles.size()
+             << " distinct paths, " << distinctImages << " distinct images");
+}
 
-    int width, height, nrComponents;
-    unsigned char *data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-    
-    if (data) {
-        GLenum format;
-        GLenum internalFormat;
-        if (nrComponents == 1) {
-            format = GL_RED;
-            internalFormat = GL_RED;
-        }
-        else if (nrComponents == 3) {
-            format = GL_RGB;
-            internalFormat = GL_SRGB8;
-        }
-        else if (nrComponents == 4) {
-            format = GL_RGBA;
-            internalFormat = GL_SRGB8_ALPHA8;
-        }
-
-        glBindTexture(GL_TEXTURE_2D, textureID);
-        glTexImage2D(GL_TEXTURE_2D, 0, internalFormat, width, height, 0, format, GL_UNSIGNED_BYTE, data);
-        glGenerateMipmap(GL_TEXTURE_2D);
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
-        std::cout << "Texture loaded successfully: " << width << "x" << height << " with " << nrComponents << " components" << std::endl;
-    }
-    else {
-        std::cout << "Failed to load texture: " << filename << std::endl;
-        std::cout << "STB Error: " << stbi_failure_reason() << std::endl;
-        glDeleteTextures(1, &textureID);
+unsigned int Model::TextureFromFile(const char *path) {
+    auto resolved = textureFiles.find(path);
+    if (resolved == textureFiles.end() || resolved->second.empty()) {
         return 0;
     }
 
-    return textureID;
-} 
\ No newline at end of file
+    // One decode and upload per image, shared by every mesh that references it
+    if (!textureCache) {
+        textureCache = std::make_unique<TextureCache>(getTextureSettings());
+        textureCache->getStreamer().setReport(&loadReport);
+    }
+    return textureCache->acquire(resolved->second);
+}
@@ -0,0 +1,33 @@
+#include "model_loader.h"
+
+ModelLoader::ModelLoader(std::string path, const ModelLoadOptions& options)
+    : path(std::move(path)) {
+    ModelLoadOptions importOptions = options;
+    importOptions.deferUpload = true;
+    importOptions.progress = &progress;
+
+    worker = std::thread([this, importOptions] {
+        auto imported = std::make_unique<Model>(this->path.c_str(), importOptions);
+        if (imported->isValid() && !progress.cancelRequested) {
+            model = std::move(imported);
+        }
+        finished = true;
+    });
+}
+
+ModelLoader::~ModelLoader() {
+    cancel();
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+std::unique_ptr<Model> ModelLoader::takeModel() {
+    if (!finished) {
+        return nullptr;
+    }
+    if (worker.joinable()) {
+        worker.join();
+    }
+    return std::move(model);
+}
@@ -1,27 +1,37 @@
 #include "renderer.h"
+#include "allocation_counter.h"
+#include "log.h"
+#include "memory_usage.h"
+#include <algorithm>
+#include <cmath>
 #include <iostream>
 #include <windows.h>
 #include <commdlg.h>
 
+// Geometry uploaded per frame while a new model is being swapped in
+static constexpr size_t UPLOAD_BUDGET_BYTES = 16 * 1024 * 1024;
+// Texture pixels streamed through PBOs per frame
+static constexpr size_t TEXTURE_BUDGET_BYTES = 8 * 1024 * 1024;
+
 Renderer::Renderer(int width, int height, const char* title) 
-    : width(width), height(height), 
-      camera(glm::vec3(0.0f, 2.0f, 8.0f)), // Move camera back and up a bit
-      lastX(static_cast<float>(width)/2.0f), 
-      lastY(static_cast<float>(height)/2.0f),
-      firstMouse(true),
-      deltaTime(0.0f), lastFrame(0.0f),
+    : camera(glm::vec3(0.0f, 2.0f, 8.0f)), // Move camera back and up a bit
+      model(nullptr),
+      shader(nullptr), // Initialize shader pointer to nullptr
+      modelScale(glm::vec3(1.0f)),
+      rotationCenter(glm::vec3(0.0f)),
+      updateRotationCenter(true),
       lightPos(glm::vec3(2.0f, 4.0f, 2.0f)), // Adjust light position for better lighting
       lightColor(glm::vec3(1.0f)),
       ambientStrength(0.2f),
       diffuseStrength(0.8f),
       specularStrength(0.5f), 
       shininess(32.0f),
-      model(nullptr),
-      modelScale(glm::vec3(1.0f)),
-      rotationCenter(glm::vec3(0.0f)),
-      updateRotationCenter(true),
-      shader(nullptr) { // Initialize shader pointer to nullptr
-    
+      width(width), height(height), 
+      lastX(static_cast<float>(width)/2.0f), 
+      lastY(static_cast<float>(height)/2.0f),
+      firstMouse(true),
+      deltaTime(0.0f), lastFrame(0.0f), frameTime(0.0f), lodPixelError(1.0f), cullMeshlets(true), cullMeshes(true) {
+
     initGLFW();
     window = glfwCreateWindow(width, height, title, NULL, NULL);
     if (window == NULL) {
@@ -54,6 +64,8 @@ void Renderer::Run() {
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
+        // Exponential average so the readout is stable enough to compare loads
+        frameTime = frameTime == 0.0f ? deltaTime * 1000.0f : frameTime * 0.95f + deltaTime * 1000.0f * 0.05f;
 
         // Poll events before ImGui frame
         glfwPollEvents();
@@ -77,6 +89,9 @@ void Renderer::Run() {
         // Process input after ImGui frame starts
         processInput();
 
+        // Advance any background load, the current model keeps rendering meanwhile
+        updateLoading();
+
         // Clear with a neutral gray background
         glClearColor(0.5f, 0.5f, 0.5f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -112,7 +127,15 @@ void Renderer::Run() {
         shader->setVec3("objectColor", glm::vec3(0.8f, 0.8f, 0.8f));
 
         if (model != nullptr) {
-            model->Draw(*shader);
+            DrawView drawView;
+            drawView.model = modelMatrix;
+            drawView.viewProjection = projection * view;
+            drawView.cameraPosition = camera.Position;
+            drawView.pixelsPerUnit = height / (2.0f * std::tan(glm::radians(camera.Zoom) * 0.5f));
+            drawView.maxPixelError = lodPixelError;
+            drawView.cullMeshlets = cullMeshlets;
+            drawView.cullMeshes = cullMeshes;
+            model->Draw(*shader, &drawView);
         }
 
         renderUI();
@@ -252,6 +275,145 @@ void Renderer::renderUI() {
             ImGui::TextColored(ImVec4(0.0f, 1.0f, 0.0f, 1.0f), "Loaded: %s", model->getFilename().c_str());
         }
 
+        // Background load progress
+        if (loader != nullptr) {
+            ImGui::ProgressBar(loader->getProgress(), ImVec2(250, 0), loader->getStage());
+            ImGui::SameLine();
+            if (ImGui::Button("Cancel")) {
+                loader->cancel();
+            }
+        } else if (pendingModel != nullptr) {
+            ImGui::ProgressBar(pendingModel->getUploadProgress(), ImVec2(250, 0), "Uploading");
+            ImGui::SameLine();
+            if (ImGui::Button("Cancel")) {
+                pendingModel = nullptr;
+            }
+        } else if (loadFailed) {
+            ImGui::TextColored(ImVec4(1.0f, 0.0f, 0.0f, 1.0f), "Last load failed");
+        }
+        static const char* profileNames[] = { "Fast preview", "Balanced", "Full validation" };
+        int profile = static_cast<int>(loadOptions.importProfile);
+        if (ImGui::Combo("Import profile (next load)", &profile, profileNames, 3)) {
+            loadOptions.importProfile = static_cast<ImportProfile>(profile);
+        }
+        ImGui::Checkbox("Instance repeated meshes (next load)", &loadOptions.instancing);
+        bool compressVertices = loadOptions.vertexFormat == VertexFormat::Quantized;
+        if (ImGui::Checkbox("Compress vertices (next load)", &compressVertices)) {
+            loadOptions.vertexFormat = compressVertices ? VertexFormat::Quantized : VertexFormat::Full;
+        }
+        ImGui::Checkbox("Cache textures (next load)", &loadOptions.cacheTextures);
+        ImGui::Checkbox("Compress textures (next load)", &loadOptions.compressTextures);
+        bool highQualityCompression = loadOptions.compressionQuality == CompressionQuality::High;
+        if (ImGui::Checkbox("High quality compression (next load)", &highQualityCompression)) {
+            loadOptions.compressionQuality = highQualityCompression ? CompressionQuality::High : CompressionQuality::Fast;
+        }
+        ImGui::Checkbox("Optimize meshes (next load)", &loadOptions.optimizeMeshes);
+        bool generateLods = loadOptions.lodLevels > 0;
+        if (ImGui::Checkbox("Generate LODs (next load)", &generateLods)) {
+            loadOptions.lodLevels = generateLods ? 4 : 0;
+        }
+        ImGui::SliderFloat("LOD max error (next load)", &loadOptions.lodMaxError, 0.001f, 0.2f, "%.3f");
+        ImGui::SliderFloat("LOD pixel error", &lodPixelError, 0.0f, 16.0f, "%.1f px");
+        ImGui::Checkbox("Meshlet culling", &cullMeshlets);
+        ImGui::Checkbox("Mesh frustum culling", &cullMeshes);
+        if (ImGui::Checkbox("Hot reload on file changes", &hotReload)) {
+            watchModel();
+        }
+        if (reloader != nullptr) {
+            ImGui::SameLine();
+            ImGui::Text("Reloading...");
+        }
+        ImGui::Checkbox("Out-of-core streaming (next load)", &loadOptions.outOfCore);
+        ImGui::Checkbox("Lean memory (next load)", &loadOptions.leanMemory);
+        static const char* logLevelNames[] = { "Debug", "Info", "Warning", "Error", "Off" };
+        int logLevel = static_cast<int>(getLogLevel());
+        if (ImGui::Combo("Log level", &logLevel, logLevelNames, 5)) {
+            setLogLevel(static_cast<LogLevel>(logLevel));
+        }
+        int cpuBudgetMB = static_cast<int>(loadOptions.streamingBudget.cpuBytes >> 20);
+        int gpuBudgetMB = static_cast<int>(loadOptions.streamingBudget.gpuBytes >> 20);
+        bool budgetChanged = ImGui::SliderInt("CPU budget (MB)", &cpuBudgetMB, 64, 32768);
+        budgetChanged |= ImGui::SliderInt("GPU budget (MB)", &gpuBudgetMB, 64, 16384);
+        if (budgetChanged) {
+            loadOptions.streamingBudget.cpuBytes = size_t(cpuBudgetMB) << 20;
+            loadOptions.streamingBudget.gpuBytes = size_t(gpuBudgetMB) << 20;
+            if (model != nullptr) {
+                model->setStreamingBudget(loadOptions.streamingBudget);
+            }
+        }
+        ImGui::Text("Frame time: %.2f ms", frameTime);
+        ImGui::Text("Process memory: %.1f MB resident, %.1f MB peak", getResidentBytes() / (1024.0 * 1024.0),
+                    getPeakResidentBytes() / (1024.0 * 1024.0));
+        const LogStats logStats = getLogStats();
+        ImGui::Text("Log: %llu lines written, %llu dropped, %.1f ms writing",
+                    static_cast<unsigned long long>(logStats.written),
+                    static_cast<unsigned long long>(logStats.dropped), logStats.sinkMilliseconds);
+        if (model != nullptr && model->hasVertexCacheStats()) {
+            const VertexCacheStats& before = model->getVertexCacheStatsBefore();
+            const VertexCacheStats& after = model->getVertexCacheStatsAfter();
+            ImGui::Text("ACMR: %.3f -> %.3f, ATVR: %.3f -> %.3f", before.acmr(), after.acmr(), before.atvr(), after.atvr());
+        }
+        if (model != nullptr) {
+            ImGui::Text("Triangles: %zu drawn of %zu, %zu culled", model->getDrawnTriangleCount(),
+                        model->getTriangleCount(), model->getCulledTriangleCount());
+            if (cullMeshes && model->getStreamer() == nullptr) {
+                ImGui::Text("Meshes: %zu drawn, %zu culled in %.3f ms (%s)", model->getDrawCallCount(),
+                            model->getCulledMeshCount(), model->getMeshCullMilliseconds(), cullPathName(bestCullPath()));
+            }
+            ImGui::Text("Vertex memory: %.2f MB (%.2f MB uncompressed)",
+                        model->getVertexBytes() / (1024.0 * 1024.0), model->getFullVertexBytes() / (1024.0 * 1024.0));
+            ImGui::Text("Index memory: %.2f MB (%.2f MB saved by 16-bit indices)",
+                        model->getIndexBytes() / (1024.0 * 1024.0), model->getIndexBytesSaved() / (1024.0 * 1024.0));
+            ImGui::Text("Texture memory: %.2f MB", model->getTextureBytes() / (1024.0 * 1024.0));
+            if (model->getInstanceCount() > model->getMeshCount()) {
+                ImGui::Text("Instancing: %zu meshes, %zu instances, %zu draw calls (%zu flattened)",
+                            model->getMeshCount(), model->getInstanceCount(), model->getDrawCallCount(),
+                            model->getInstanceCount());
+                ImGui::Text("Geometry: %.2f MB + %.2f MB transforms (%.2f MB flattened)",
+                            (model->getVertexBytes() + model->getIndexBytes()) / (1024.0 * 1024.0),
+                            model->getInstanceBytes() / (1024.0 * 1024.0),
+                            model->getFlattenedGeometryBytes() / (1024.0 * 1024.0));
+            }
+            const SceneGraph& graph = model->getSceneGraph();
+            if (graph.getNodeCount() > 0) {
+                ImGui::Text("Scene graph: %zu nodes, %zu updated in %.3f ms", graph.getNodeCount(),
+                            graph.getLastUpdateCount(), graph.getLastUpdateMilliseconds());
+            }
+            if (model->canExplode()) {
+                float explode = model->getExplodeAmount();
+                if (ImGui::SliderFloat("Explode", &explode, 0.0f, 2.0f)) {
+                    model->setExplodeAmount(explode);
+                }
+            }
+        }
+        if (model != nullptr && model->getTextureStreamer() != nullptr) {
+            const TextureStreamer* textures = model->getTextureStreamer();
+            ImGui::Text("Texture cache: %zu hits, %zu misses, %.1f MB read", textures->getCacheHits(),
+                        textures->getCacheMisses(), textures->getCacheBytesRead() / (1024.0 * 1024.0));
+        }
+        if (model != nullptr && ImGui::CollapsingHeader("Load report")) {
+            const LoadReport& report = model->getLoadReport();
+            ImGui::Text("Total: %.1f ms%s", report.getElapsedMilliseconds(), report.isFinished() ? "" : " (in progress)");
+            for (const auto& stage : report.getStages()) {
+                ImGui::Text("%-20s %9.1f ms %8.1f MB/s %12.0f %s/s", stage.name.c_str(), stage.milliseconds,
+                            stage.megabytesPerSecond(), stage.itemsPerSecond(), stage.itemName.c_str());
+                if (allocationCountingEnabled()) {
+                    ImGui::SameLine();
+                    ImGui::Text("%10llu allocs", static_cast<unsigned long long>(stage.allocations));
+                }
+            }
+        }
+        if (model != nullptr && model->getStreamer() != nullptr) {
+            const MeshStreamer* streamer = model->getStreamer();
+            ImGui::Text("Resident chunks: %zu of %zu (%zu paging in)", streamer->getResidentCount(),
+                        streamer->getChunkCount(), streamer->getPendingCount());
+            ImGui::Text("Geometry: %.1f MB CPU, %.1f MB GPU", streamer->getCpuBytes() / (1024.0 * 1024.0),
+                        streamer->getGpuBytes() / (1024.0 * 1024.0));
+        }
+        if (model != nullptr && model->getPendingTextureCount() > 0) {
+            ImGui::Text("Streaming textures: %zu remaining", model->getPendingTextureCount());
+        }
+
         // Add Reset Camera button
         if (ImGui::Button("Reset Camera", ImVec2(120, 0)) && model != nullptr) {
             // Reset camera to initial position
@@ -307,6 +469,14 @@ void Renderer::renderUI() {
 }
 
 void Renderer::cleanup() {
+    // Models own GL objects, release them while the context still exists
+    watcher = nullptr;
+    reloader = nullptr;
+    loader = nullptr;
+    retiredLoaders.clear();
+    pendingModel = nullptr;
+    model = nullptr;
+
     ImGui_ImplOpenGL3_Shutdown();
     ImGui_ImplGlfw_Shutdown();
     ImGui::DestroyContext();
@@ -436,19 +606,118 @@ void Renderer::scrollCallback(GLFWwindow* window, double xoffset, double yoffset
 }
 
 void Renderer::loadModel(const char* path) {
-    // No need to manually delete the old model, unique_ptr handles it
-    model = std::make_unique<Model>(path);
-    
-    // Check if model loaded successfully
-    if (!model->isValid()) {
-        model = nullptr;  // Reset the unique_ptr
-        std::cerr << "ERROR::RENDERER: Failed to load model from path: " << path << std::endl;
+    // Imports still in flight are cancelled, not joined: they may be inside a
+    // step that never checks for cancellation
+    retireLoader(loader);
+    retireLoader(reloader);
+    watcher = nullptr;  // Edits to the old model must not start a reload over the new one
+    pendingModel = nullptr;
+    loadFailed = false;
+    framePendingModel = true;
+    // Hot reload diffs per-mesh hashes, only computed during the background import when it is on
+    loadOptions.hashMeshes = hotReload;
+    loader = std::make_unique<ModelLoader>(path, loadOptions);
+}
+
+void Renderer::retireLoader(std::unique_ptr<ModelLoader>& retired) {
+    if (retired != nullptr) {
+        retired->cancel();
+        retiredLoaders.push_back(std::move(retired));
+    }
+}
+
+void Renderer::updateLoading() {
+    // Joining a finished worker returns right away
+    retiredLoaders.erase(std::remove_if(retiredLoaders.begin(), retiredLoaders.end(),
+                                        [](const std::unique_ptr<ModelLoader>& retired) {
+                                            return retired->isFinished();
+                                        }),
+                         retiredLoaders.end());
+
+    if (loader != nullptr && loader->isFinished()) {
+        pendingModel = loader->takeModel();
+        if (pendingModel == nullptr) {
+            if (!loader->isCancelled()) {
+                loadFailed = true;
+                LOG_ERROR("ERROR::RENDERER: Failed to load model from path: " << loader->getPath());
+            }
+        }
+        loader = nullptr;
+    }
+
+    updateHotReload();
+
+    // Textures appear progressively on the current model
+    if (model != nullptr) {
+        model->streamTextures(TEXTURE_BUDGET_BYTES);
+    }
+
+    if (pendingModel != nullptr) {
+        pendingModel->streamTextures(TEXTURE_BUDGET_BYTES);
+        // Spread the GL upload over several frames, then swap in one step
+        if (pendingModel->upload(UPLOAD_BUDGET_BYTES)) {
+            model = std::move(pendingModel);
+            if (framePendingModel) {
+                onModelReady();
+            }
+            watchModel();
+        }
+    }
+}
+
+void Renderer::updateHotReload() {
+    if (watcher != nullptr && model != nullptr) {
+        for (const auto& file : watcher->takeChanged()) {
+            if (file == model->getSourcePath()) {
+                // Same options as the displayed model so unchanged meshes hash the same.
+                // A model loaded without hashes is replaced whole once, later reloads can diff.
+                LOG_INFO("Model file changed, re-importing " << file);
+                ModelLoadOptions reloadOptions = model->getOptions();
+                reloadOptions.hashMeshes = true;
+                retireLoader(reloader);
+                reloader = std::make_unique<ModelLoader>(file, reloadOptions);
+            } else {
+                model->reloadTexture(file);
+            }
+        }
+    }
+
+    if (reloader == nullptr || !reloader->isFinished()) {
         return;
     }
+    std::unique_ptr<Model> fresh = reloader->takeModel();
+    reloader = nullptr;
+    if (loader != nullptr || (pendingModel != nullptr && framePendingModel)) {
+        // Another model is on its way in and replaces the displayed one anyway
+        return;
+    }
+    if (fresh == nullptr) {
+        LOG_ERROR("ERROR::RENDERER: Hot reload failed, keeping the displayed model");
+    } else if (model != nullptr && model->replaceChangedMeshes(*fresh)) {
+        watchModel();  // Materials may reference new images
+    } else {
+        // The mesh layout changed, upload the new model whole without moving the camera
+        pendingModel = std::move(fresh);
+        framePendingModel = false;
+    }
+}
+
+void Renderer::watchModel() {
+    if (!hotReload || model == nullptr || !model->isValid()) {
+        watcher = nullptr;
+        return;
+    }
+    if (watcher == nullptr) {
+        watcher = std::make_unique<FileWatcher>();
+    }
+    std::vector<std::string> files = model->getTextureFiles();
+    files.push_back(model->getSourcePath());
+    watcher->watch(files);
+}
 
+void Renderer::onModelReady() {
     // Get model bounds
     glm::vec3 modelSize = model->getSize();
-    glm::vec3 modelCenter = model->getCenter();
     
     // Calculate the diagonal size of the model's bounding box
     float modelDiagonal = glm::length(modelSize);
@@ -495,7 +764,7 @@ void Renderer::loadModel(const char* path) {
     );
     
     // Debug output
-    std::cout << "Model diagonal size: " << modelDiagonal << std::endl;
-    std::cout << "Applied scale: " << scale << std::endl;
-    std::cout << "Camera distance: " << CAMERA_DISTANCE << std::endl;
+    LOG_DEBUG("Model diagonal size: " << modelDiagonal);
+    LOG_DEBUG("Applied scale: " << scale);
+    LOG_DEBUG("Camera distance: " << CAMERA_DISTANCE);
 } 
\ No newline at end of file
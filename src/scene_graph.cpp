@@ -0,0 +1,116 @@
+#include "scene_graph.h"
+#include <algorithm>
+#include <chrono>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PGV_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace {
+
+// out = a * b for column-major matrices; out must not alias either input
+inline void multiply(const glm::mat4& a, const glm::mat4& b, glm::mat4& out) {
+#ifdef PGV_HAVE_SSE2
+    const float* left = &a[0][0];
+    const float* right = &b[0][0];
+    float* result = &out[0][0];
+    const __m128 a0 = _mm_loadu_ps(left);
+    const __m128 a1 = _mm_loadu_ps(left + 4);
+    const __m128 a2 = _mm_loadu_ps(left + 8);
+    const __m128 a3 = _mm_loadu_ps(left + 12);
+    // Column j of the product is a's columns weighted by column j of b
+    for (int j = 0; j < 4; j++) {
+        __m128 column = _mm_mul_ps(a0, _mm_set1_ps(right[j * 4 + 0]));
+        column = _mm_add_ps(column, _mm_mul_ps(a1, _mm_set1_ps(right[j * 4 + 1])));
+        column = _mm_add_ps(column, _mm_mul_ps(a2, _mm_set1_ps(right[j * 4 + 2])));
+        column = _mm_add_ps(column, _mm_mul_ps(a3, _mm_set1_ps(right[j * 4 + 3])));
+        _mm_storeu_ps(result + j * 4, column);
+    }
+#else
+    out = a * b;
+#endif
+}
+
+} // namespace
+
+uint32_t SceneGraph::addNode(int32_t parent, const glm::mat4& local) {
+    const uint32_t node = static_cast<uint32_t>(parents.size());
+    parents.push_back(parent >= 0 && static_cast<uint32_t>(parent) < node ? parent : NO_PARENT);
+    locals.push_back(local);
+    worlds.push_back(local);
+    dirty.push_back(1);
+    updated.push_back(0);
+    firstDirty = std::min<size_t>(firstDirty, node);
+    return node;
+}
+
+void SceneGraph::clear() {
+    parents.clear();
+    locals.clear();
+    worlds.clear();
+    dirty.clear();
+    updated.clear();
+    batch.clear();
+    firstDirty = SIZE_MAX;
+    lastUpdateCount = 0;
+    version++;
+}
+
+void SceneGraph::reserve(size_t count) {
+    parents.reserve(count);
+    locals.reserve(count);
+    worlds.reserve(count);
+    dirty.reserve(count);
+    updated.reserve(count);
+}
+
+void SceneGraph::setLocalTransform(uint32_t node, const glm::mat4& local) {
+    locals[node] = local;
+    dirty[node] = 1;
+    firstDirty = std::min<size_t>(firstDirty, node);
+}
+
+size_t SceneGraph::update() {
+    auto start = std::chrono::steady_clock::now();
+    if (firstDirty == SIZE_MAX) {
+        // Nothing moved, the flags keep describing the current version
+        lastUpdateCount = 0;
+        lastUpdateMilliseconds = 0.0;
+        return 0;
+    }
+    // Only the nodes the previous update touched have their flag set
+    for (uint32_t node : batch) {
+        updated[node] = 0;
+    }
+    batch.clear();
+
+    // Parents come first, so one pass carries a change down the whole subtree.
+    // The scan only reads flags and parent indices, the matrices of clean nodes stay untouched.
+    const size_t count = parents.size();
+    for (size_t i = firstDirty; i < count; i++) {
+        const int32_t parent = parents[i];
+        if (dirty[i] || (parent != NO_PARENT && updated[parent])) {
+            dirty[i] = 0;
+            updated[i] = 1;
+            batch.push_back(static_cast<uint32_t>(i));
+        }
+    }
+    firstDirty = SIZE_MAX;
+
+    for (uint32_t node : batch) {
+        const int32_t parent = parents[node];
+        if (parent == NO_PARENT) {
+            worlds[node] = locals[node];
+        } else {
+            multiply(worlds[parent], locals[node], worlds[node]);
+        }
+    }
+
+    if (!batch.empty()) {
+        version++;
+    }
+    lastUpdateCount = batch.size();
+    lastUpdateMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return lastUpdateCount;
+}
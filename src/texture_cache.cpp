@@ -0,0 +1,46 @@
+#include "texture_cache.h"
+
+TextureCache::TextureCache(const TextureStreamSettings& settings) : streamer(settings) {
+}
+
+TextureCache::~TextureCache() {
+    for (const auto& entry : entries) {
+        glDeleteTextures(1, &entry.first);
+    }
+}
+
+unsigned int TextureCache::acquire(const std::string& filename) {
+    auto it = idsByFile.find(filename);
+    if (it != idsByFile.end()) {
+        entries[it->second].refs++;
+        hits++;
+        return it->second;
+    }
+
+    unsigned int textureId = streamer.request(filename);
+    idsByFile[filename] = textureId;
+    Entry& entry = entries[textureId];
+    entry.filename = filename;
+    entry.refs = 1;
+    return textureId;
+}
+
+void TextureCache::release(unsigned int textureId) {
+    auto it = entries.find(textureId);
+    if (it == entries.end() || --it->second.refs > 0) {
+        return;
+    }
+    idsByFile.erase(it->second.filename);
+    entries.erase(it);
+    streamer.forget(textureId);
+    glDeleteTextures(1, &textureId);
+}
+
+bool TextureCache::reload(const std::string& filename) {
+    auto it = idsByFile.find(filename);
+    if (it == idsByFile.end()) {
+        return false;
+    }
+    streamer.reload(it->second, filename);
+    return true;
+}
@@ -0,0 +1,456 @@
+#include "texture_compress.h"
+#include "log.h"
+#include "texture_mips.h"
+#include "thread_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PGV_HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char MAGIC[4] = { 'P', 'G', 'B', 'C' };
+const uint32_t FILE_VERSION = 2;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t format;
+    uint32_t width;
+    uint32_t height;
+    uint32_t mipCount;
+    uint64_t sourceSize;
+    int64_t sourceModified;
+};
+
+bool headerMatches(const FileHeader& header, const SourceStamp& source) {
+    return std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.version == FILE_VERSION &&
+           header.sourceSize == source.size && header.sourceModified == source.modified;
+}
+
+uint16_t to565(const float color[3]) {
+    int r = std::min(31, std::max(0, static_cast<int>(color[0] * (31.0f / 255.0f) + 0.5f)));
+    int g = std::min(63, std::max(0, static_cast<int>(color[1] * (63.0f / 255.0f) + 0.5f)));
+    int b = std::min(31, std::max(0, static_cast<int>(color[2] * (31.0f / 255.0f) + 0.5f)));
+    return static_cast<uint16_t>((r << 11) | (g << 5) | b);
+}
+
+void from565(uint16_t color, int rgb[3]) {
+    int r = (color >> 11) & 31;
+    int g = (color >> 5) & 63;
+    int b = color & 31;
+    rgb[0] = (r << 3) | (r >> 2);
+    rgb[1] = (g << 2) | (g >> 4);
+    rgb[2] = (b << 3) | (b >> 2);
+}
+
+// Nearest of the four palette colors per pixel, 2 bits each; returns the squared error
+uint32_t bc1IndicesScalar(const unsigned char rgba[64], const int palette[4][3], uint32_t& indices) {
+    uint32_t error = 0;
+    indices = 0;
+    for (int i = 0; i < 16; i++) {
+        const unsigned char* pixel = rgba + i * 4;
+        int best = 0;
+        int bestDistance = 0x7fffffff;
+        for (int c = 0; c < 4; c++) {
+            int dr = pixel[0] - palette[c][0];
+            int dg = pixel[1] - palette[c][1];
+            int db = pixel[2] - palette[c][2];
+            int distance = dr * dr + dg * dg + db * db;
+            if (distance < bestDistance) {
+                bestDistance = distance;
+                best = c;
+            }
+        }
+        indices |= static_cast<uint32_t>(best) << (i * 2);
+        error += static_cast<uint32_t>(bestDistance);
+    }
+    return error;
+}
+
+#ifdef PGV_HAVE_SSE2
+// Same result as the scalar version, four pixels against one palette color per step
+uint32_t bc1IndicesSSE2(const unsigned char rgba[64], const int palette[4][3], uint32_t& indices) {
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i rgbMask = _mm_setr_epi16(-1, -1, -1, 0, -1, -1, -1, 0);
+    __m128i colors[4];
+    for (int c = 0; c < 4; c++) {
+        colors[c] = _mm_setr_epi16(static_cast<short>(palette[c][0]), static_cast<short>(palette[c][1]),
+                                   static_cast<short>(palette[c][2]), 0,
+                                   static_cast<short>(palette[c][0]), static_cast<short>(palette[c][1]),
+                                   static_cast<short>(palette[c][2]), 0);
+    }
+
+    uint32_t error = 0;
+    indices = 0;
+    for (int group = 0; group < 4; group++) {
+        __m128i pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(rgba + group * 16));
+        __m128i lo = _mm_and_si128(_mm_unpacklo_epi8(pixels, zero), rgbMask);
+        __m128i hi = _mm_and_si128(_mm_unpackhi_epi8(pixels, zero), rgbMask);
+
+        __m128i bestDistance = _mm_set1_epi32(0x7fffffff);
+        __m128i bestIndex = zero;
+        for (int c = 0; c < 4; c++) {
+            __m128i dlo = _mm_sub_epi16(lo, colors[c]);
+            __m128i dhi = _mm_sub_epi16(hi, colors[c]);
+            // (dr^2 + dg^2, db^2) per pixel, then fold the pairs
+            __m128 sumLo = _mm_castsi128_ps(_mm_madd_epi16(dlo, dlo));
+            __m128 sumHi = _mm_castsi128_ps(_mm_madd_epi16(dhi, dhi));
+            __m128i even = _mm_castps_si128(_mm_shuffle_ps(sumLo, sumHi, _MM_SHUFFLE(2, 0, 2, 0)));
+            __m128i odd = _mm_castps_si128(_mm_shuffle_ps(sumLo, sumHi, _MM_SHUFFLE(3, 1, 3, 1)));
+            __m128i distance = _mm_add_epi32(even, odd);
+
+            __m128i closer = _mm_cmplt_epi32(distance, bestDistance);
+            bestDistance = _mm_or_si128(_mm_and_si128(closer, distance), _mm_andnot_si128(closer, bestDistance));
+            bestIndex = _mm_or_si128(_mm_and_si128(closer, _mm_set1_epi32(c)), _mm_andnot_si128(closer, bestIndex));
+        }
+
+        alignas(16) int32_t distances[4];
+        alignas(16) int32_t best[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(distances), bestDistance);
+        _mm_store_si128(reinterpret_cast<__m128i*>(best), bestIndex);
+        for (int k = 0; k < 4; k++) {
+            indices |= static_cast<uint32_t>(best[k]) << ((group * 4 + k) * 2);
+            error += static_cast<uint32_t>(distances[k]);
+        }
+    }
+    return error;
+}
+#endif
+
+// Builds the 4-color palette for two endpoints and picks indices, c0 >= c1 on return
+uint32_t encodeBC1Endpoints(const unsigned char rgba[64], uint16_t& c0, uint16_t& c1, uint32_t& indices) {
+    // c0 > c1 selects the 4-color mode, equal endpoints collapse to one color anyway
+    if (c0 < c1) {
+        std::swap(c0, c1);
+    }
+    int palette[4][3];
+    from565(c0, palette[0]);
+    from565(c1, palette[1]);
+    for (int k = 0; k < 3; k++) {
+        if (c0 == c1) {
+            palette[2][k] = palette[3][k] = palette[0][k];
+        } else {
+            palette[2][k] = (2 * palette[0][k] + palette[1][k]) / 3;
+            palette[3][k] = (palette[0][k] + 2 * palette[1][k]) / 3;
+        }
+    }
+#ifdef PGV_HAVE_SSE2
+    return bc1IndicesSSE2(rgba, palette, indices);
+#else
+    return bc1IndicesScalar(rgba, palette, indices);
+#endif
+}
+
+// Least-squares endpoints for fixed indices (weights 1, 0, 2/3, 1/3 on c0)
+bool refineEndpoints(const unsigned char rgba[64], uint32_t indices, float e0[3], float e1[3]) {
+    static const float weights[4] = { 1.0f, 0.0f, 2.0f / 3.0f, 1.0f / 3.0f };
+    float aa = 0.0f, bb = 0.0f, ab = 0.0f;
+    float ax[3] = {}, bx[3] = {};
+    for (int i = 0; i < 16; i++) {
+        float alpha = weights[(indices >> (i * 2)) & 3];
+        float beta = 1.0f - alpha;
+        aa += alpha * alpha;
+        bb += beta * beta;
+        ab += alpha * beta;
+        for (int k = 0; k < 3; k++) {
+            ax[k] += alpha * rgba[i * 4 + k];
+            bx[k] += beta * rgba[i * 4 + k];
+        }
+    }
+    float det = aa * bb - ab * ab;
+    if (std::fabs(det) < 1e-6f) {
+        return false;
+    }
+    for (int k = 0; k < 3; k++) {
+        e0[k] = std::min(255.0f, std::max(0.0f, (ax[k] * bb - bx[k] * ab) / det));
+        e1[k] = std::min(255.0f, std::max(0.0f, (bx[k] * aa - ax[k] * ab) / det));
+    }
+    return true;
+}
+
+void principalAxisEndpoints(const unsigned char rgba[64], float e0[3], float e1[3]) {
+    float mean[3] = {};
+    for (int i = 0; i < 16; i++) {
+        for (int k = 0; k < 3; k++) {
+            mean[k] += rgba[i * 4 + k] / 16.0f;
+        }
+    }
+    float cov[6] = {};  // xx xy xz yy yz zz
+    for (int i = 0; i < 16; i++) {
+        float d[3] = { rgba[i * 4] - mean[0], rgba[i * 4 + 1] - mean[1], rgba[i * 4 + 2] - mean[2] };
+        cov[0] += d[0] * d[0]; cov[1] += d[0] * d[1]; cov[2] += d[0] * d[2];
+        cov[3] += d[1] * d[1]; cov[4] += d[1] * d[2]; cov[5] += d[2] * d[2];
+    }
+    // Power iteration converges on the dominant eigenvector in a few steps
+    float axis[3] = { 1.0f, 1.0f, 1.0f };
+    for (int iteration = 0; iteration < 8; iteration++) {
+        float next[3] = {
+            cov[0] * axis[0] + cov[1] * axis[1] + cov[2] * axis[2],
+            cov[1] * axis[0] + cov[3] * axis[1] + cov[4] * axis[2],
+            cov[2] * axis[0] + cov[4] * axis[1] + cov[5] * axis[2],
+        };
+        float length = std::sqrt(next[0] * next[0] + next[1] * next[1] + next[2] * next[2]);
+        if (length < 1e-6f) {
+            break;
+        }
+        for (int k = 0; k < 3; k++) {
+            axis[k] = next[k] / length;
+        }
+    }
+    float minT = 0.0f, maxT = 0.0f;
+    for (int i = 0; i < 16; i++) {
+        float t = (rgba[i * 4] - mean[0]) * axis[0] + (rgba[i * 4 + 1] - mean[1]) * axis[1] +
+                  (rgba[i * 4 + 2] - mean[2]) * axis[2];
+        minT = std::min(minT, t);
+        maxT = std::max(maxT, t);
+    }
+    for (int k = 0; k < 3; k++) {
+        e0[k] = std::min(255.0f, std::max(0.0f, mean[k] + axis[k] * maxT));
+        e1[k] = std::min(255.0f, std::max(0.0f, mean[k] + axis[k] * minT));
+    }
+}
+
+size_t blockBytes(GLenum format) {
+    return (format == COMPRESSED_SRGB_S3TC_DXT1 || format == GL_COMPRESSED_RED_RGTC1) ? 8 : 16;
+}
+
+std::vector<unsigned char> compressLevel(const unsigned char* pixels, int width, int height, int components,
+                                         GLenum format, CompressionQuality quality, ThreadPool* pool) {
+    const size_t blocksX = (width + 3) / 4;
+    const size_t blocksY = (height + 3) / 4;
+    const size_t bytesPerBlock = blockBytes(format);
+    std::vector<unsigned char> data(blocksX * blocksY * bytesPerBlock);
+
+    auto encodeRow = [&](size_t by) {
+        unsigned char rgba[64];
+        unsigned char channel[16];
+        for (size_t bx = 0; bx < blocksX; bx++) {
+            // Edge blocks repeat the last row/column
+            for (int y = 0; y < 4; y++) {
+                int py = std::min(static_cast<int>(by * 4) + y, height - 1);
+                for (int x = 0; x < 4; x++) {
+                    int px = std::min(static_cast<int>(bx * 4) + x, width - 1);
+                    const unsigned char* src = pixels + (static_cast<size_t>(py) * width + px) * components;
+                    unsigned char* dst = rgba + (y * 4 + x) * 4;
+                    dst[0] = src[0];
+                    dst[1] = components > 1 ? src[1] : src[0];
+                    dst[2] = components > 2 ? src[2] : src[0];
+                    dst[3] = components > 3 ? src[3] : 255;
+                }
+            }
+
+            unsigned char* out = data.data() + (by * blocksX + bx) * bytesPerBlock;
+            if (format == COMPRESSED_SRGB_S3TC_DXT1) {
+                encodeBC1(rgba, out, quality);
+            } else if (format == COMPRESSED_SRGB_ALPHA_S3TC_DXT5) {
+                for (int i = 0; i < 16; i++) {
+                    channel[i] = rgba[i * 4 + 3];
+                }
+                encodeBC4(channel, out);
+                encodeBC1(rgba, out + 8, quality);
+            } else {
+                // BC4 is one BC4 block, BC5 one per channel
+                for (int c = 0; c < (format == GL_COMPRESSED_RED_RGTC1 ? 1 : 2); c++) {
+                    for (int i = 0; i < 16; i++) {
+                        channel[i] = rgba[i * 4 + c];
+                    }
+                    encodeBC4(channel, out + c * 8);
+                }
+            }
+        }
+    };
+
+    if (pool != nullptr && blocksY > 1) {
+        pool->parallelFor(blocksY, encodeRow);
+    } else {
+        for (size_t by = 0; by < blocksY; by++) {
+            encodeRow(by);
+        }
+    }
+    return data;
+}
+
+} // namespace
+
+GLenum compressedFormatFor(int components) {
+    switch (components) {
+        case 1: return GL_COMPRESSED_RED_RGTC1;
+        case 2: return GL_COMPRESSED_RG_RGTC2;
+        case 3: return COMPRESSED_SRGB_S3TC_DXT1;
+        default: return COMPRESSED_SRGB_ALPHA_S3TC_DXT5;
+    }
+}
+
+void encodeBC1(const unsigned char rgba[64], unsigned char out[8], CompressionQuality quality) {
+    float e0[3], e1[3];
+    if (quality == CompressionQuality::Fast) {
+        float minColor[3] = { 255.0f, 255.0f, 255.0f };
+        float maxColor[3] = { 0.0f, 0.0f, 0.0f };
+        for (int i = 0; i < 16; i++) {
+            for (int k = 0; k < 3; k++) {
+                minColor[k] = std::min(minColor[k], static_cast<float>(rgba[i * 4 + k]));
+                maxColor[k] = std::max(maxColor[k], static_cast<float>(rgba[i * 4 + k]));
+            }
+        }
+        // Pull the box in slightly, the extremes are rarely worth an exact endpoint
+        for (int k = 0; k < 3; k++) {
+            float inset = (maxColor[k] - minColor[k]) / 16.0f;
+            e0[k] = maxColor[k] - inset;
+            e1[k] = minColor[k] + inset;
+        }
+    } else {
+        principalAxisEndpoints(rgba, e0, e1);
+    }
+
+    uint16_t c0 = to565(e0), c1 = to565(e1);
+    uint32_t indices;
+    uint32_t error = encodeBC1Endpoints(rgba, c0, c1, indices);
+
+    if (quality == CompressionQuality::High && c0 != c1) {
+        // One least-squares pass over the chosen indices, kept only if it helps
+        float r0[3], r1[3];
+        if (refineEndpoints(rgba, indices, r0, r1)) {
+            uint16_t rc0 = to565(r0), rc1 = to565(r1);
+            uint32_t refinedIndices;
+            uint32_t refinedError = encodeBC1Endpoints(rgba, rc0, rc1, refinedIndices);
+            if (refinedError < error) {
+                c0 = rc0;
+                c1 = rc1;
+                indices = refinedIndices;
+            }
+        }
+    }
+
+    out[0] = static_cast<unsigned char>(c0 & 0xff);
+    out[1] = static_cast<unsigned char>(c0 >> 8);
+    out[2] = static_cast<unsigned char>(c1 & 0xff);
+    out[3] = static_cast<unsigned char>(c1 >> 8);
+    for (int i = 0; i < 4; i++) {
+        out[4 + i] = static_cast<unsigned char>((indices >> (i * 8)) & 0xff);
+    }
+}
+
+void encodeBC4(const unsigned char values[16], unsigned char out[8]) {
+    int minValue = 255, maxValue = 0;
+    for (int i = 0; i < 16; i++) {
+        minValue = std::min(minValue, static_cast<int>(values[i]));
+        maxValue = std::max(maxValue, static_cast<int>(values[i]));
+    }
+    out[0] = static_cast<unsigned char>(maxValue);
+    out[1] = static_cast<unsigned char>(minValue);
+
+    // 8-value mode (a0 > a1): index 0 is max, 1 is min, 2..7 step from max to min
+    uint64_t bits = 0;
+    const int range = maxValue - minValue;
+    for (int i = 0; i < 16 && range > 0; i++) {
+        int step = ((values[i] - minValue) * 14 + range) / (2 * range);  // 0 = min ... 7 = max
+        uint64_t index = step == 7 ? 0 : step == 0 ? 1 : static_cast<uint64_t>(8 - step);
+        bits |= index << (i * 3);
+    }
+    for (int i = 0; i < 6; i++) {
+        out[2 + i] = static_cast<unsigned char>((bits >> (i * 8)) & 0xff);
+    }
+}
+
+void compressImage(const unsigned char* pixels, int width, int height, int components,
+                   CompressionQuality quality, CompressedImage& out, ThreadPool* pool) {
+    out.format = compressedFormatFor(components);
+    out.width = width;
+    out.height = height;
+    out.mips.clear();
+
+    // GL can't generate mips for compressed textures, so the chain is built here
+    MipChain chain;
+    buildMipChain(pixels, width, height, components, chain, pool);
+    for (size_t level = 0; level < chain.levels.size(); level++) {
+        out.mips.push_back(compressLevel(chain.levels[level].data(), mipDimension(width, level),
+                                         mipDimension(height, level), components, out.format, quality, pool));
+    }
+}
+
+bool compressedImageMatches(const std::string& path, const SourceStamp& source) {
+    std::ifstream in(path, std::ios::binary);
+    FileHeader header;
+    return in.read(reinterpret_cast<char*>(&header), sizeof(header)) && headerMatches(header, source);
+}
+
+bool loadCompressedImage(const std::string& path, CompressedImage& image, const SourceStamp& source) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) {
+        return false;
+    }
+    FileHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof(header)) || !headerMatches(header, source) ||
+        header.mipCount == 0 || header.mipCount > 32) {
+        return false;
+    }
+
+    image.format = header.format;
+    image.width = static_cast<int>(header.width);
+    image.height = static_cast<int>(header.height);
+    image.mips.resize(header.mipCount);
+    int levelWidth = image.width, levelHeight = image.height;
+    for (auto& mip : image.mips) {
+        size_t expected = ((levelWidth + 3) / 4) * ((levelHeight + 3) / 4) * blockBytes(image.format);
+        mip.resize(expected);
+        if (!in.read(reinterpret_cast<char*>(mip.data()), static_cast<std::streamsize>(expected))) {
+            LOG_ERROR("ERROR::TEXTURE_COMPRESS::LOAD: Truncated file " << path);
+            return false;
+        }
+        levelWidth = std::max(1, levelWidth / 2);
+        levelHeight = std::max(1, levelHeight / 2);
+    }
+    return true;
+}
+
+bool saveCompressedImage(const std::string& path, const CompressedImage& image, const SourceStamp& source) {
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+
+    FileHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FILE_VERSION;
+    header.format = image.format;
+    header.width = static_cast<uint32_t>(image.width);
+    header.height = static_cast<uint32_t>(image.height);
+    header.mipCount = static_cast<uint32_t>(image.mips.size());
+    header.sourceSize = source.size;
+    header.sourceModified = source.modified;
+
+    // Several textures may finish at once, each writes its own temporary file
+    const std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            LOG_ERROR("ERROR::TEXTURE_COMPRESS::SAVE: Cannot open " << tempPath << " for writing");
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto& mip : image.mips) {
+            out.write(reinterpret_cast<const char*>(mip.data()), static_cast<std::streamsize>(mip.size()));
+        }
+        if (!out) {
+            LOG_ERROR("ERROR::TEXTURE_COMPRESS::SAVE: Failed writing " << tempPath);
+            out.close();
+            fs::remove(tempPath, ec);
+            return false;
+        }
+    }
+    fs::rename(tempPath, path, ec);
+    if (ec) {
+        LOG_ERROR("ERROR::TEXTURE_COMPRESS::SAVE: Cannot replace " << path << ": " << ec.message());
+        fs::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
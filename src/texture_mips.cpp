@@ -0,0 +1,204 @@
+#include "texture_mips.h"
+#include "log.h"
+#include "thread_pool.h"
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+
+namespace fs = std::filesystem;
+
+namespace {
+
+const char MAGIC[4] = { 'P', 'G', 'M', 'P' };
+const uint32_t FILE_VERSION = 2;
+
+struct FileHeader {
+    char magic[4];
+    uint32_t version;
+    uint32_t width;
+    uint32_t height;
+    uint32_t components;
+    uint32_t levelCount;
+    uint64_t sourceSize;
+    int64_t sourceModified;
+};
+
+bool headerMatches(const FileHeader& header, const SourceStamp& source) {
+    return std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0 && header.version == FILE_VERSION &&
+           header.sourceSize == source.size && header.sourceModified == source.modified;
+}
+
+size_t levelBytes(int width, int height, int components, size_t level) {
+    return static_cast<size_t>(mipDimension(width, level)) * mipDimension(height, level) * components;
+}
+
+const std::array<float, 256>& srgbToLinear() {
+    static const std::array<float, 256> table = [] {
+        std::array<float, 256> values;
+        for (int i = 0; i < 256; i++) {
+            float c = i / 255.0f;
+            values[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return values;
+    }();
+    return table;
+}
+
+unsigned char linearToSrgb(float value) {
+    static const std::array<unsigned char, 4096> table = [] {
+        std::array<unsigned char, 4096> values;
+        for (int i = 0; i < 4096; i++) {
+            float l = i / 4095.0f;
+            float s = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+            values[i] = static_cast<unsigned char>(std::min(255.0f, std::max(0.0f, s * 255.0f + 0.5f)));
+        }
+        return values;
+    }();
+    int index = static_cast<int>(value * 4095.0f + 0.5f);
+    return table[std::min(4095, std::max(0, index))];
+}
+
+void downsample(const unsigned char* src, int width, int height, int components,
+                unsigned char* dst, ThreadPool* pool) {
+    static const float weights[4] = { 1.0f, 3.0f, 3.0f, 1.0f };
+    const int halfWidth = std::max(1, width / 2);
+    const int halfHeight = std::max(1, height / 2);
+    const int colorChannels = components >= 3 ? 3 : 0;  // sRGB, the rest is linear
+    const auto& linear = srgbToLinear();
+
+    auto filterRow = [&](size_t y) {
+        int rows[4];
+        for (int j = 0; j < 4; j++) {
+            rows[j] = std::min(height - 1, std::max(0, static_cast<int>(y) * 2 - 1 + j));
+        }
+        for (int x = 0; x < halfWidth; x++) {
+            int columns[4];
+            for (int i = 0; i < 4; i++) {
+                columns[i] = std::min(width - 1, std::max(0, x * 2 - 1 + i));
+            }
+            for (int c = 0; c < components; c++) {
+                float sum = 0.0f;
+                for (int j = 0; j < 4; j++) {
+                    const unsigned char* row = src + static_cast<size_t>(rows[j]) * width * components;
+                    for (int i = 0; i < 4; i++) {
+                        unsigned char value = row[columns[i] * components + c];
+                        sum += weights[j] * weights[i] * (c < colorChannels ? linear[value] : value);
+                    }
+                }
+                sum /= 64.0f;
+                dst[(y * halfWidth + x) * components + c] = c < colorChannels
+                    ? linearToSrgb(sum)
+                    : static_cast<unsigned char>(std::min(255.0f, sum + 0.5f));
+            }
+        }
+    };
+
+    if (pool != nullptr && halfHeight > 1) {
+        pool->parallelFor(halfHeight, filterRow);
+    } else {
+        for (int y = 0; y < halfHeight; y++) {
+            filterRow(y);
+        }
+    }
+}
+
+} // namespace
+
+void buildMipChain(const unsigned char* pixels, int width, int height, int components,
+                   MipChain& out, ThreadPool* pool) {
+    out.width = width;
+    out.height = height;
+    out.components = components;
+    out.levels.clear();
+    out.levels.emplace_back(pixels, pixels + levelBytes(width, height, components, 0));
+    for (size_t level = 1; mipDimension(width, level - 1) > 1 || mipDimension(height, level - 1) > 1; level++) {
+        out.levels.emplace_back(levelBytes(width, height, components, level));
+        downsample(out.levels[level - 1].data(), mipDimension(width, level - 1), mipDimension(height, level - 1),
+                   components, out.levels[level].data(), pool);
+    }
+}
+
+bool saveMipChain(const std::string& path, const MipChain& chain, const SourceStamp& source) {
+    std::error_code ec;
+    fs::create_directories(fs::path(path).parent_path(), ec);
+
+    FileHeader header = {};
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FILE_VERSION;
+    header.width = static_cast<uint32_t>(chain.width);
+    header.height = static_cast<uint32_t>(chain.height);
+    header.components = static_cast<uint32_t>(chain.components);
+    header.levelCount = static_cast<uint32_t>(chain.levels.size());
+    header.sourceSize = source.size;
+    header.sourceModified = source.modified;
+
+    const std::string tempPath = path + ".tmp";
+    {
+        std::ofstream out(tempPath, std::ios::binary | std::ios::trunc);
+        if (!out) {
+            LOG_ERROR("ERROR::TEXTURE_MIPS::SAVE: Cannot open " << tempPath << " for writing");
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto& level : chain.levels) {
+            out.write(reinterpret_cast<const char*>(level.data()), static_cast<std::streamsize>(level.size()));
+        }
+        if (!out) {
+            LOG_ERROR("ERROR::TEXTURE_MIPS::SAVE: Failed writing " << tempPath);
+            out.close();
+            fs::remove(tempPath, ec);
+            return false;
+        }
+    }
+    fs::rename(tempPath, path, ec);
+    if (ec) {
+        LOG_ERROR("ERROR::TEXTURE_MIPS::SAVE: Cannot replace " << path << ": " << ec.message());
+        fs::remove(tempPath, ec);
+        return false;
+    }
+    return true;
+}
+
+bool mipChainMatches(const std::string& path, const SourceStamp& source) {
+    std::ifstream in(path, std::ios::binary);
+    FileHeader header;
+    return in.read(reinterpret_cast<char*>(&header), sizeof(header)) && headerMatches(header, source);
+}
+
+bool MappedMipChain::open(const std::string& path, const SourceStamp& source) {
+    levels.clear();
+    if (!file.open(path)) {
+        return false;
+    }
+
+    FileHeader header;
+    if (file.size() < sizeof(header)) {
+        file.close();
+        return false;
+    }
+    std::memcpy(&header, file.data(), sizeof(header));
+    if (!headerMatches(header, source) || header.components < 1 || header.components > 4 || header.levelCount == 0 || header.levelCount > 32) {
+        file.close();
+        return false;
+    }
+
+    width = static_cast<int>(header.width);
+    height = static_cast<int>(header.height);
+    components = static_cast<int>(header.components);
+    size_t offset = sizeof(header);
+    for (size_t level = 0; level < header.levelCount; level++) {
+        size_t bytes = levelBytes(width, height, components, level);
+        if (offset + bytes > file.size()) {
+            LOG_ERROR("ERROR::TEXTURE_MIPS::OPEN: Truncated file " << path);
+            levels.clear();
+            file.close();
+            return false;
+        }
+        levels.push_back(file.data() + offset);
+        offset += bytes;
+    }
+    return true;
+}
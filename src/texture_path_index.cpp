@@ -0,0 +1,106 @@
+#include "texture_path_index.h"
+#include "log.h"
+#include <algorithm>
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+TexturePathIndex::TexturePathIndex(const std::string& modelDirectory) : modelDirectory(modelDirectory) {}
+
+void TexturePathIndex::buildIndex() {
+    indexed = true;
+    auto start = std::chrono::steady_clock::now();
+    if (!modelDirectory.empty()) {
+        // The model folder walk already covers modelDirectory/Textures
+        indexFolder(modelDirectory);
+        indexFolder(modelDirectory + "/../Textures");
+    }
+    std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+    LOG_INFO("Indexed " << fileCount << " files for texture lookup in " << elapsed.count() << " ms");
+}
+
+std::string TexturePathIndex::normalize(const std::string& path) {
+    std::string normalized = path;
+    std::replace(normalized.begin(), normalized.end(), '\\', '/');
+    while (normalized.compare(0, 2, "./") == 0) {
+        normalized.erase(0, 2);
+    }
+    std::transform(normalized.begin(), normalized.end(), normalized.begin(),
+                   [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return normalized;
+}
+
+void TexturePathIndex::indexFolder(const std::string& root) {
+    std::error_code ec;
+    if (!fs::is_directory(root, ec)) {
+        return;
+    }
+    // Model folders can sit inside large project trees, so the walk is bounded
+    fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec);
+    for (; !ec && it != fs::recursive_directory_iterator() && fileCount < MAX_FILES; it.increment(ec)) {
+        if (it.depth() >= MAX_DEPTH) {
+            it.disable_recursion_pending();
+        }
+        if (!it->is_regular_file(ec)) {
+            continue;
+        }
+        const fs::path& file = it->path();
+        std::string filename = file.generic_string();
+        byRelativePath.emplace(normalize(fs::relative(file, root, ec).generic_string()), filename);
+        byName.emplace(normalize(file.filename().string()), filename);
+        fileCount++;
+    }
+    if (fileCount >= MAX_FILES) {
+        LOG_WARNING("Texture index stopped at " << MAX_FILES << " files in " << root);
+    }
+}
+
+std::string TexturePathIndex::resolve(const std::string& texturePath) {
+    auto cached = results.find(texturePath);
+    if (cached != results.end()) {
+        return cached->second;
+    }
+
+    // Well-formed paths name the file directly, one probe is cheaper than walking the tree
+    std::string found;
+    std::string separators = texturePath;
+    std::replace(separators.begin(), separators.end(), '\\', '/');
+    std::error_code ec;
+    if (fs::path(separators).is_absolute()) {
+        if (fs::is_regular_file(separators, ec)) {
+            found = separators;
+        }
+    } else if (!modelDirectory.empty() && fs::is_regular_file(modelDirectory + "/" + separators, ec)) {
+        found = modelDirectory + "/" + separators;
+    }
+    if (!found.empty()) {
+        results.emplace(texturePath, found);
+        return found;
+    }
+
+    if (!indexed) {
+        buildIndex();
+    }
+    std::string normalized = normalize(texturePath);
+    auto relative = byRelativePath.find(normalized);
+    if (relative != byRelativePath.end()) {
+        found = relative->second;
+    } else {
+        // Paths authored on another machine usually still name the right file
+        std::string name = normalized.substr(normalized.find_last_of('/') + 1);
+        auto byFileName = byName.find(name);
+        if (byFileName != byName.end()) {
+            found = byFileName->second;
+            LOG_DEBUG("Matched texture " << texturePath << " by file name: " << found);
+        } else if (fs::is_regular_file(texturePath, ec)) {
+            // Relative to the working directory, as before the index existed
+            found = texturePath;
+        } else {
+            LOG_WARNING("Failed to find texture: " << texturePath);
+        }
+    }
+    results.emplace(texturePath, found);
+    return found;
+}
@@ -0,0 +1,440 @@
+#include "texture_streamer.h"
+#include <stb/stb_image.h>
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <limits>
+#include <sstream>
+#include "hash.h"
+#include "log.h"
+
+namespace fs = std::filesystem;
+
+namespace {
+
+void formatsFor(int components, GLenum& format, GLenum& internalFormat) {
+    switch (components) {
+        case 1: format = GL_RED; internalFormat = GL_RED; break;
+        case 2: format = GL_RG; internalFormat = GL_RG; break;
+        case 3: format = GL_RGB; internalFormat = GL_SRGB8; break;
+        default: format = GL_RGBA; internalFormat = GL_SRGB8_ALPHA8; break;
+    }
+}
+
+// One of each for the whole process, whichever models are loaded
+ThreadPool& decodePool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+// Mip filtering and BC encoding, decode jobs wait on its parallelFor
+ThreadPool& filterPool() {
+    static ThreadPool pool;
+    return pool;
+}
+
+} // namespace
+
+TextureStreamer::TextureStreamer(const TextureStreamSettings& settings)
+    : settings(settings), queue(std::make_shared<DecodeQueue>()) {
+    glGenBuffers(PBO_COUNT, pbos);
+}
+
+TextureStreamer::~TextureStreamer() {
+    // Queued decodes return without touching the streamer, only the ones
+    // already running are waited for
+    {
+        std::unique_lock<std::mutex> lock(queue->mutex);
+        queue->cancelled = true;
+        queue->changed.wait(lock, [this] { return queue->running == 0; });
+    }
+    glDeleteBuffers(PBO_COUNT, pbos);
+}
+
+size_t TextureStreamer::DecodedImage::levelCount() const {
+    return mapped.isOpen() ? mapped.getLevelCount() : mips.levels.size();
+}
+
+const unsigned char* TextureStreamer::DecodedImage::level(size_t index) const {
+    return mapped.isOpen() ? mapped.getLevel(index) : mips.levels[index].data();
+}
+
+unsigned int TextureStreamer::request(const std::string& filename) {
+    unsigned int textureId;
+    glGenTextures(1, &textureId);
+
+    // White placeholder so the texture is complete until the real image arrives
+    const unsigned char white[4] = { 255, 255, 255, 255 };
+    glBindTexture(GL_TEXTURE_2D, textureId);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_SRGB8_ALPHA8, 1, 1, 0, GL_RGBA, GL_UNSIGNED_BYTE, white);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    queueDecode(textureId, filename);
+    return textureId;
+}
+
+void TextureStreamer::reload(unsigned int textureId, const std::string& filename) {
+    // The old image stays bound until the new levels replace it
+    queueDecode(textureId, filename);
+}
+
+void TextureStreamer::queueDecode(unsigned int textureId, const std::string& filename) {
+    requested++;
+    const uint64_t generation = ++nextGeneration;
+    latestRequest[textureId] = generation;
+    std::shared_ptr<DecodeQueue> shared = queue;
+    decodePool().submit([this, shared, textureId, generation, filename] {
+        {
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            if (shared->cancelled) {
+                return;
+            }
+            shared->running++;
+        }
+        auto image = std::make_unique<DecodedImage>();
+        image->textureId = textureId;
+        image->generation = generation;
+        image->filename = filename;
+        decode(*image);
+        std::lock_guard<std::mutex> lock(shared->mutex);
+        shared->ready.push_back(std::move(image));
+        shared->running--;
+        shared->changed.notify_all();
+    });
+}
+
+void TextureStreamer::decode(DecodedImage& image) {
+    SourceStamp source;
+    const std::string path = cachePath(settings, image.filename, source);
+    if (!path.empty()) {
+        ScopedTimer timer(report, "Texture cache read", "textures");
+        bool hit = false;
+        size_t bytes = 0;
+        if (settings.compress && loadCompressedImage(path, image.compressed, source)) {
+            hit = true;
+            image.width = image.compressed.width;
+            image.height = image.compressed.height;
+            for (const auto& mip : image.compressed.mips) {
+                bytes += mip.size();
+            }
+        } else if (!settings.compress && image.mapped.open(path, source)) {
+            hit = true;
+            image.width = image.mapped.getWidth();
+            image.height = image.mapped.getHeight();
+            image.components = image.mapped.getComponents();
+            bytes = image.mapped.getFileBytes();
+        }
+        if (hit) {
+            cacheHits++;
+            cacheBytesRead += bytes;
+            timer.addBytes(bytes);
+            timer.addItems(1);
+            LOG_DEBUG("Texture cache hit: " << image.filename << " (" << bytes / 1024 << " KB)");
+            return;
+        }
+        cacheMisses++;
+        LOG_DEBUG("Texture cache miss: " << image.filename);
+    }
+
+    std::unique_ptr<unsigned char, void (*)(void*)> pixels(nullptr, stbi_image_free);
+    {
+        ScopedTimer timer(report, "Texture decode", "textures");
+        pixels.reset(stbi_load(image.filename.c_str(), &image.width, &image.height, &image.components, 0));
+        if (pixels) {
+            timer.addBytes(static_cast<uint64_t>(image.width) * image.height * image.components);
+            timer.addItems(1);
+        }
+    }
+    if (!pixels) {
+        LOG_WARNING("Failed to load texture: " << image.filename);
+        LOG_WARNING("STB Error: " << stbi_failure_reason());
+        return;
+    }
+    if (queue->cancelled) {
+        return;  // Nobody will upload it, skip the filtering
+    }
+
+    // Rows and blocks go to the filter pool, so one large texture still uses every core
+    const uint64_t pixelBytes = static_cast<uint64_t>(image.width) * image.height * image.components;
+    if (settings.compress) {
+        {
+            ScopedTimer timer(report, "Texture compress", "textures");
+            timer.addBytes(pixelBytes);
+            timer.addItems(1);
+            compressImage(pixels.get(), image.width, image.height, image.components,
+                          settings.quality, image.compressed, &filterPool());
+        }
+        if (!path.empty()) {
+            ScopedTimer timer(report, "Texture cache write", "textures");
+            timer.addItems(saveCompressedImage(path, image.compressed, source) ? 1 : 0);
+        }
+    } else {
+        {
+            ScopedTimer timer(report, "Texture mips", "textures");
+            timer.addBytes(pixelBytes);
+            timer.addItems(1);
+            buildMipChain(pixels.get(), image.width, image.height, image.components, image.mips, &filterPool());
+        }
+        if (!path.empty()) {
+            ScopedTimer timer(report, "Texture cache write", "textures");
+            timer.addItems(saveMipChain(path, image.mips, source) ? 1 : 0);
+        }
+    }
+}
+
+bool TextureStreamer::bake(const std::string& filename, const TextureStreamSettings& settings, bool force,
+                           ThreadPool* pool, bool* skipped) {
+    SourceStamp source;
+    const std::string path = cachePath(settings, filename, source);
+    if (path.empty()) {
+        LOG_ERROR("ERROR::TEXTURE_STREAMER::BAKE: No cache location for " << filename);
+        return false;
+    }
+    const bool current = !force && (settings.compress ? compressedImageMatches(path, source)
+                                                      : mipChainMatches(path, source));
+    if (skipped) {
+        *skipped = current;
+    }
+    if (current) {
+        return true;
+    }
+
+    int width, height, components;
+    std::unique_ptr<unsigned char, void (*)(void*)> pixels(
+        stbi_load(filename.c_str(), &width, &height, &components, 0), stbi_image_free);
+    if (!pixels) {
+        LOG_ERROR("ERROR::TEXTURE_STREAMER::BAKE: Failed to decode " << filename << ": "
+                  << stbi_failure_reason());
+        return false;
+    }
+    if (settings.compress) {
+        CompressedImage compressed;
+        compressImage(pixels.get(), width, height, components, settings.quality, compressed, pool);
+        return saveCompressedImage(path, compressed, source);
+    }
+    MipChain mips;
+    buildMipChain(pixels.get(), width, height, components, mips, pool);
+    return saveMipChain(path, mips, source);
+}
+
+std::string TextureStreamer::cachePath(const TextureStreamSettings& settings, const std::string& filename,
+                                       SourceStamp& source) {
+    if (settings.cacheDirectory.empty()) {
+        return std::string();
+    }
+    // One file per image and output format, the quality preset only changes
+    // compressed output. Size and timestamp go in the file header instead, so
+    // an edited image overwrites its entry rather than adding another.
+    std::error_code ec;
+    const std::string absolute = fs::absolute(filename, ec).string();
+    source.size = fs::file_size(filename, ec);
+    if (ec) {
+        return std::string();
+    }
+    source.modified = static_cast<int64_t>(fs::last_write_time(filename, ec).time_since_epoch().count());
+    uint64_t hash = fnv1a(absolute.data(), absolute.size());
+    if (settings.compress) {
+        const int quality = static_cast<int>(settings.quality);
+        hash = fnv1a(&quality, sizeof(quality), hash);
+    }
+
+    std::ostringstream name;
+    name << std::hex << hash << (settings.compress ? ".bctex" : ".mips");
+    return (fs::path(settings.cacheDirectory) / name.str()).string();
+}
+
+void TextureStreamer::forget(unsigned int textureId) {
+    latestRequest.erase(textureId);
+    auto it = bytesByTexture.find(textureId);
+    if (it != bytesByTexture.end()) {
+        textureBytes -= it->second;
+        bytesByTexture.erase(it);
+    }
+}
+
+size_t TextureStreamer::pendingCount() const {
+    return requested - completed;
+}
+
+void TextureStreamer::pump(size_t byteBudget) {
+    {
+        // Called every frame, only time the calls that have something to upload
+        std::lock_guard<std::mutex> lock(queue->mutex);
+        if (!current && queue->ready.empty()) {
+            return;
+        }
+    }
+    ScopedTimer timer(report, "Texture upload", "textures");
+    size_t spent = 0;
+    while (spent < byteBudget) {
+        if (!current) {
+            std::lock_guard<std::mutex> lock(queue->mutex);
+            if (queue->ready.empty()) {
+                break;
+            }
+            current = std::move(queue->ready.front());
+            queue->ready.pop_front();
+        }
+
+        // GL hands out deleted names again, so a texture released or reloaded
+        // since this request is only recognised by its generation
+        auto latest = latestRequest.find(current->textureId);
+        const bool stale = latest == latestRequest.end() || latest->second != current->generation;
+        if (stale || (current->levelsUploaded == 0 && current->rowsUploaded == 0 && !beginUpload(*current))) {
+            // Superseded, or the decode failed and the placeholder stays
+            current = nullptr;
+            completed++;
+            continue;
+        }
+
+        bool done;
+        if (!current->compressed.mips.empty()) {
+            spent += uploadMips(*current, byteBudget - spent);
+            done = current->levelsUploaded == current->compressed.mips.size();
+        } else {
+            spent += uploadRows(*current, byteBudget - spent);
+            done = current->levelsUploaded == current->levelCount();
+        }
+        if (done) {
+            finishUpload(*current);
+            current = nullptr;
+            completed++;
+            timer.addItems(1);
+        }
+    }
+    timer.addBytes(spent);
+}
+
+void TextureStreamer::finish() {
+    // The shared pool may be busy with other streamers, wait for this one's images only
+    while (pendingCount() > 0) {
+        {
+            std::unique_lock<std::mutex> lock(queue->mutex);
+            queue->changed.wait(lock, [this] { return current || !queue->ready.empty(); });
+        }
+        pump(std::numeric_limits<size_t>::max());
+    }
+}
+
+bool TextureStreamer::beginUpload(DecodedImage& image) {
+    const bool compressed = !image.compressed.mips.empty();
+    if (image.levelCount() == 0 && !compressed) {
+        return false;
+    }
+
+    // Levels arrive in order, sample level 0 alone until the chain is complete
+    glBindTexture(GL_TEXTURE_2D, image.textureId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, 0);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    if (compressed) {
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.compressed.mips.size() - 1));
+    } else {
+        GLenum format, internalFormat;
+        formatsFor(image.components, format, internalFormat);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(image.levelCount() - 1));
+        for (size_t level = 0; level < image.levelCount(); level++) {
+            glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), internalFormat,
+                         mipDimension(image.width, level), mipDimension(image.height, level),
+                         0, format, GL_UNSIGNED_BYTE, nullptr);
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return true;
+}
+
+size_t TextureStreamer::uploadRows(DecodedImage& image, size_t byteBudget) {
+    const size_t level = image.levelsUploaded;
+    const int width = mipDimension(image.width, level);
+    const int height = mipDimension(image.height, level);
+    const size_t rowBytes = static_cast<size_t>(width) * image.components;
+    const int remainingRows = height - image.rowsUploaded;
+    // Always make progress, even if a single row exceeds the budget
+    int rows = static_cast<int>(std::min<size_t>(remainingRows, std::max<size_t>(1, byteBudget / rowBytes)));
+    const size_t bytes = rows * rowBytes;
+
+    // Rotate through a few PBOs so we never write one the driver is still reading
+    unsigned int pbo = pbos[nextPbo];
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, pbo);
+    if (pboSizes[nextPbo] < bytes) {
+        glBufferData(GL_PIXEL_UNPACK_BUFFER, bytes, nullptr, GL_STREAM_DRAW);
+        pboSizes[nextPbo] = bytes;
+    }
+    void* mapped = glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, bytes,
+                                    GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    if (mapped) {
+        // Cache hits copy straight out of the mapped file
+        std::memcpy(mapped, image.level(level) + image.rowsUploaded * rowBytes, bytes);
+        glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+
+        GLenum format, internalFormat;
+        formatsFor(image.components, format, internalFormat);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+        glBindTexture(GL_TEXTURE_2D, image.textureId);
+        glTexSubImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), 0, image.rowsUploaded, width, rows,
+                        format, GL_UNSIGNED_BYTE, nullptr);
+        glBindTexture(GL_TEXTURE_2D, 0);
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+    } else {
+        LOG_ERROR("ERROR::TEXTURE_STREAMER: Failed to map pixel buffer");
+    }
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+    nextPbo = (nextPbo + 1) % PBO_COUNT;
+
+    image.rowsUploaded += rows;
+    if (image.rowsUploaded == height) {
+        image.levelsUploaded++;
+        image.rowsUploaded = 0;
+    }
+    return bytes;
+}
+
+size_t TextureStreamer::uploadMips(DecodedImage& image, size_t byteBudget) {
+    // Compressed levels are small enough to upload straight from client memory
+    const CompressedImage& compressed = image.compressed;
+    size_t spent = 0;
+    glBindTexture(GL_TEXTURE_2D, image.textureId);
+    do {
+        const size_t level = image.levelsUploaded;
+        const auto& mip = compressed.mips[level];
+        glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(level), compressed.format,
+                               mipDimension(compressed.width, level), mipDimension(compressed.height, level),
+                               0, static_cast<GLsizei>(mip.size()), mip.data());
+        spent += mip.size();
+        image.levelsUploaded++;
+    } while (image.levelsUploaded < compressed.mips.size() && spent < byteBudget);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    return spent;
+}
+
+void TextureStreamer::finishUpload(DecodedImage& image) {
+    size_t bytes = 0;
+    if (!image.compressed.mips.empty()) {
+        for (const auto& mip : image.compressed.mips) {
+            bytes += mip.size();
+        }
+    } else {
+        for (size_t level = 0; level < image.levelCount(); level++) {
+            bytes += static_cast<size_t>(mipDimension(image.width, level)) * mipDimension(image.height, level) *
+                     image.components;
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, image.textureId);
+    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+    glBindTexture(GL_TEXTURE_2D, 0);
+
+    // A reload replaces the bytes counted for the old image
+    size_t& counted = bytesByTexture[image.textureId];
+    textureBytes += bytes - counted;
+    counted = bytes;
+    if (!image.compressed.mips.empty()) {
+        LOG_DEBUG("Texture loaded successfully: " << image.width << "x" << image.height
+                  << " block compressed, " << image.compressed.mips.size() << " levels");
+    } else {
+        LOG_DEBUG("Texture loaded successfully: " << image.width << "x" << image.height
+                  << " with " << image.components << " components");
+    }
+}
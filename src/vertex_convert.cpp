@@ -0,0 +1,167 @@
+#include "vertex_convert.h"
+#include <algorithm>
+#include <cstddef>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define PGV_HAVE_SSE2 1
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#define PGV_TARGET_AVX
+#else
+#define PGV_TARGET_AVX __attribute__((target("avx")))
+#endif
+#endif
+
+static_assert(sizeof(Vertex) == 32, "SIMD conversion assumes a 32-byte Vertex");
+static_assert(offsetof(Vertex, Normal) == 12 && offsetof(Vertex, TexCoords) == 24,
+              "SIMD conversion assumes position, normal, texcoords packed in that order");
+
+namespace {
+
+const float ZERO3[4] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+void convertScalar(const VertexStreams& src, size_t begin, size_t end, Vertex* dst,
+                   glm::vec3& minBounds, glm::vec3& maxBounds) {
+    for (size_t i = begin; i < end; i++) {
+        const float* p = src.positions + i * 3;
+        const float* n = src.normals ? src.normals + i * 3 : ZERO3;
+        const float* t = src.texCoords ? src.texCoords + i * 3 : ZERO3;
+        Vertex& v = dst[i];
+        v.Position = glm::vec3(p[0], p[1], p[2]);
+        v.Normal = glm::vec3(n[0], n[1], n[2]);
+        v.TexCoords = glm::vec2(t[0], t[1]);
+        minBounds = glm::min(minBounds, v.Position);
+        maxBounds = glm::max(maxBounds, v.Position);
+    }
+}
+
+#ifdef PGV_HAVE_SSE2
+
+// Each 16-byte load reads one float past the vertex, so the last vertex of a
+// stream is always left to the scalar tail
+void convertSSE2(const VertexStreams& src, size_t count, Vertex* dst,
+                 glm::vec3& minBounds, glm::vec3& maxBounds) {
+    const size_t simdCount = count > 0 ? count - 1 : 0;
+    __m128 mn = _mm_set_ps(0.0f, minBounds.z, minBounds.y, minBounds.x);
+    __m128 mx = _mm_set_ps(0.0f, maxBounds.z, maxBounds.y, maxBounds.x);
+    const __m128 zero = _mm_setzero_ps();
+
+    for (size_t i = 0; i < simdCount; i++) {
+        __m128 p = _mm_loadu_ps(src.positions + i * 3);                  // px py pz --
+        __m128 n = src.normals ? _mm_loadu_ps(src.normals + i * 3) : zero;      // nx ny nz --
+        __m128 t = src.texCoords ? _mm_loadu_ps(src.texCoords + i * 3) : zero;  // u  v  -- --
+
+        __m128 pzNx = _mm_shuffle_ps(p, n, _MM_SHUFFLE(0, 0, 2, 2));     // pz pz nx nx
+        __m128 lo = _mm_shuffle_ps(p, pzNx, _MM_SHUFFLE(2, 0, 1, 0));    // px py pz nx
+        __m128 hi = _mm_shuffle_ps(n, t, _MM_SHUFFLE(1, 0, 2, 1));       // ny nz u  v
+
+        float* out = reinterpret_cast<float*>(dst + i);
+        _mm_storeu_ps(out, lo);
+        _mm_storeu_ps(out + 4, hi);
+
+        mn = _mm_min_ps(mn, p);
+        mx = _mm_max_ps(mx, p);
+    }
+
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, mn);
+    minBounds = glm::vec3(lanes[0], lanes[1], lanes[2]);
+    _mm_store_ps(lanes, mx);
+    maxBounds = glm::vec3(lanes[0], lanes[1], lanes[2]);
+    convertScalar(src, simdCount, count, dst, minBounds, maxBounds);
+}
+
+// Same shuffles as the SSE2 path, two vertices per 256-bit register
+PGV_TARGET_AVX
+void convertAVX(const VertexStreams& src, size_t count, Vertex* dst,
+                glm::vec3& minBounds, glm::vec3& maxBounds) {
+    const size_t pairCount = count > 1 ? (count - 1) / 2 : 0;
+    __m256 mn = _mm256_set_ps(0.0f, minBounds.z, minBounds.y, minBounds.x, 0.0f, minBounds.z, minBounds.y, minBounds.x);
+    __m256 mx = _mm256_set_ps(0.0f, maxBounds.z, maxBounds.y, maxBounds.x, 0.0f, maxBounds.z, maxBounds.y, maxBounds.x);
+    const __m256 zero = _mm256_setzero_ps();
+
+    for (size_t pair = 0; pair < pairCount; pair++) {
+        const size_t i = pair * 2;
+        __m256 p = _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src.positions + i * 3)),
+                                        _mm_loadu_ps(src.positions + i * 3 + 3), 1);
+        __m256 n = src.normals
+            ? _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src.normals + i * 3)),
+                                   _mm_loadu_ps(src.normals + i * 3 + 3), 1)
+            : zero;
+        __m256 t = src.texCoords
+            ? _mm256_insertf128_ps(_mm256_castps128_ps256(_mm_loadu_ps(src.texCoords + i * 3)),
+                                   _mm_loadu_ps(src.texCoords + i * 3 + 3), 1)
+            : zero;
+
+        __m256 pzNx = _mm256_shuffle_ps(p, n, _MM_SHUFFLE(0, 0, 2, 2));
+        __m256 lo = _mm256_shuffle_ps(p, pzNx, _MM_SHUFFLE(2, 0, 1, 0));
+        __m256 hi = _mm256_shuffle_ps(n, t, _MM_SHUFFLE(1, 0, 2, 1));
+
+        float* out = reinterpret_cast<float*>(dst + i);
+        _mm256_storeu_ps(out, _mm256_permute2f128_ps(lo, hi, 0x20));      // vertex i
+        _mm256_storeu_ps(out + 8, _mm256_permute2f128_ps(lo, hi, 0x31));  // vertex i + 1
+
+        mn = _mm256_min_ps(mn, p);
+        mx = _mm256_max_ps(mx, p);
+    }
+
+    __m128 mn4 = _mm_min_ps(_mm256_castps256_ps128(mn), _mm256_extractf128_ps(mn, 1));
+    __m128 mx4 = _mm_max_ps(_mm256_castps256_ps128(mx), _mm256_extractf128_ps(mx, 1));
+    alignas(16) float lanes[4];
+    _mm_store_ps(lanes, mn4);
+    minBounds = glm::vec3(lanes[0], lanes[1], lanes[2]);
+    _mm_store_ps(lanes, mx4);
+    maxBounds = glm::vec3(lanes[0], lanes[1], lanes[2]);
+    _mm256_zeroupper();
+    convertScalar(src, pairCount * 2, count, dst, minBounds, maxBounds);
+}
+
+bool cpuSupportsAVX() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    bool osxsave = (info[2] & (1 << 27)) != 0;
+    bool avx = (info[2] & (1 << 28)) != 0;
+    // The OS must also save the YMM registers on context switches
+    return osxsave && avx && (_xgetbv(0) & 0x6) == 0x6;
+#else
+    return __builtin_cpu_supports("avx");
+#endif
+}
+
+#endif // PGV_HAVE_SSE2
+
+} // namespace
+
+VertexConvertPath bestVertexConvertPath() {
+#ifdef PGV_HAVE_SSE2
+    static const VertexConvertPath best = cpuSupportsAVX() ? VertexConvertPath::AVX : VertexConvertPath::SSE2;
+    return best;
+#else
+    return VertexConvertPath::Scalar;
+#endif
+}
+
+const char* vertexConvertPathName(VertexConvertPath path) {
+    switch (path) {
+        case VertexConvertPath::SSE2: return "SSE2";
+        case VertexConvertPath::AVX: return "AVX";
+        default: return "scalar";
+    }
+}
+
+void convertVertices(const VertexStreams& src, size_t count, Vertex* dst,
+                     glm::vec3& minBounds, glm::vec3& maxBounds, VertexConvertPath path) {
+#ifdef PGV_HAVE_SSE2
+    if (path == VertexConvertPath::AVX) {
+        convertAVX(src, count, dst, minBounds, maxBounds);
+        return;
+    }
+    if (path == VertexConvertPath::SSE2) {
+        convertSSE2(src, count, dst, minBounds, maxBounds);
+        return;
+    }
+#endif
+    convertScalar(src, 0, count, dst, minBounds, maxBounds);
+}
@@ -0,0 +1,102 @@
+#include "vertex_quantize.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+uint16_t floatToHalf(float value) {
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    const uint32_t sign = (bits >> 16) & 0x8000;
+    const uint32_t rawExponent = (bits >> 23) & 0xff;
+    uint32_t mantissa = bits & 0x7fffff;
+
+    if (rawExponent == 0xff) {
+        // Inf stays inf, NaN stays NaN
+        return static_cast<uint16_t>(sign | 0x7c00 | (mantissa ? 0x200 : 0));
+    }
+    const int32_t exponent = static_cast<int32_t>(rawExponent) - 127 + 15;
+    if (exponent >= 31) {
+        return static_cast<uint16_t>(sign | 0x7c00);
+    }
+    if (exponent <= 0) {
+        // Subnormal half, or too small and flushed to signed zero
+        if (exponent < -10) {
+            return static_cast<uint16_t>(sign);
+        }
+        mantissa |= 0x800000;
+        const uint32_t shift = static_cast<uint32_t>(14 - exponent);
+        uint32_t half = mantissa >> shift;
+        const uint32_t remainder = mantissa & ((1u << shift) - 1);
+        const uint32_t halfway = 1u << (shift - 1);
+        if (remainder > halfway || (remainder == halfway && (half & 1))) {
+            half++;
+        }
+        return static_cast<uint16_t>(sign | half);
+    }
+
+    // Round to nearest even, a carry out of the mantissa correctly bumps the exponent
+    uint32_t half = sign | (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+    const uint32_t remainder = mantissa & 0x1fff;
+    if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1))) {
+        half++;
+    }
+    return static_cast<uint16_t>(half);
+}
+
+glm::vec2 octEncode(const glm::vec3& normal) {
+    float l1 = std::fabs(normal.x) + std::fabs(normal.y) + std::fabs(normal.z);
+    if (l1 == 0.0f) {
+        return glm::vec2(0.0f, 0.0f);
+    }
+    glm::vec2 e(normal.x / l1, normal.y / l1);
+    if (normal.z < 0.0f) {
+        // Fold the lower hemisphere over the diagonals
+        glm::vec2 folded((1.0f - std::fabs(e.y)) * (e.x >= 0.0f ? 1.0f : -1.0f),
+                         (1.0f - std::fabs(e.x)) * (e.y >= 0.0f ? 1.0f : -1.0f));
+        e = folded;
+    }
+    return e;
+}
+
+namespace {
+
+uint16_t toUnorm16(float value) {
+    return static_cast<uint16_t>(std::lround(std::min(std::max(value, 0.0f), 1.0f) * 65535.0f));
+}
+
+int16_t toSnorm16(float value) {
+    return static_cast<int16_t>(std::lround(std::min(std::max(value, -1.0f), 1.0f) * 32767.0f));
+}
+
+} // namespace
+
+void quantizeVertices(const std::vector<Vertex>& vertices, const glm::vec3& minBounds,
+                      const glm::vec3& maxBounds, std::vector<PackedVertex>& out) {
+    out.resize(vertices.size());
+    quantizeVertices(vertices.data(), vertices.size(), minBounds, maxBounds, out.data());
+}
+
+void quantizeVertices(const Vertex* vertices, size_t count, const glm::vec3& minBounds,
+                      const glm::vec3& maxBounds, PackedVertex* out) {
+    glm::vec3 extent = maxBounds - minBounds;
+    glm::vec3 invExtent(extent.x > 0.0f ? 1.0f / extent.x : 0.0f,
+                        extent.y > 0.0f ? 1.0f / extent.y : 0.0f,
+                        extent.z > 0.0f ? 1.0f / extent.z : 0.0f);
+
+    for (size_t i = 0; i < count; i++) {
+        const Vertex& v = vertices[i];
+        PackedVertex& packed = out[i];
+        glm::vec3 unit = (v.Position - minBounds) * invExtent;
+        packed.position[0] = toUnorm16(unit.x);
+        packed.position[1] = toUnorm16(unit.y);
+        packed.position[2] = toUnorm16(unit.z);
+        packed.position[3] = 0;
+
+        glm::vec2 oct = octEncode(v.Normal);
+        packed.normal[0] = toSnorm16(oct.x);
+        packed.normal[1] = toSnorm16(oct.y);
+
+        packed.texCoords[0] = floatToHalf(v.TexCoords.x);
+        packed.texCoords[1] = floatToHalf(v.TexCoords.y);
+    }
+}